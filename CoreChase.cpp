@@ -0,0 +1,78 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreChase.h"
+
+#include "CoreListJoin.h" // for core_results
+#include "CoreUtil.h"     // for crcu16, crcu32
+
+CORE_KERNEL_BEGIN
+
+/* align an offset to point to a 32b value */
+#define align_mem(x) (void *)(4 + (((intptr_t)(x)-1) & ~3))
+
+uint32_t core_init_chase(uint32_t blksize, void *memblk, int32_t seed, chase_params *p)
+{
+    uint32_t N = (blksize > 4) ? (blksize - 4) / sizeof(uint32_t) : 0;
+    uint32_t *ring = (uint32_t *)align_mem(memblk);
+    uint32_t rnd = (uint32_t)seed;
+    uint32_t i, j, tmp;
+
+    for (i = 0; i < N; i++)
+        ring[i] = i;
+    /* Sattolo's shuffle, the permutation is a single cycle through every slot */
+    for (i = N - 1; (N > 1) && (i > 0); i--)
+    {
+        rnd = rnd * 1103515245 + 12345;
+        j = (rnd >> 8) % i;
+        tmp = ring[i];
+        ring[i] = ring[j];
+        ring[j] = tmp;
+    }
+
+    p->N = N;
+    p->ring = ring;
+    return N;
+}
+
+void workload_chase_init(core_results *res, uint32_t blksize, void *memblk)
+{
+    core_init_chase(blksize, memblk, (int32_t)res->seed1 | (((int32_t)res->seed2) << 16), &(res->chase));
+}
+
+uint16_t workload_chase_bench(core_results *res, int16_t)
+{
+    uint16_t crc = core_bench_chase(&(res->chase), 0);
+    res->crc = crcu16(crc, res->crc);
+    return crc;
+}
+
+uint16_t core_bench_chase(chase_params *p, uint16_t crc)
+{
+    uint32_t *ring = p->ring;
+    uint32_t N = p->N;
+    uint32_t idx = 0, hash = 0, i;
+
+    /* every load depends on the previous one, the hash stays off the critical path */
+    for (i = 0; i < N; i++)
+    {
+        idx = ring[idx];
+        hash = hash * 33 + idx;
+    }
+    crc = crcu32(hash, crc);
+    crc = crcu32(idx, crc);
+    return crc;
+}
+
+CORE_KERNEL_END
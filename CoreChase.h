@@ -0,0 +1,31 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreKernel.h"
+#include <cstdint>
+
+struct chase_params
+{
+    uint32_t N;     /* Number of slots in the ring */
+    uint32_t *ring; /* ring[i] is the index of the slot following slot i */
+};
+
+CORE_KERNEL_BEGIN
+
+uint32_t core_init_chase(uint32_t blksize, void *memblk, int32_t seed, chase_params *p);
+uint16_t core_bench_chase(chase_params *p, uint16_t crc);
+
+CORE_KERNEL_END
@@ -0,0 +1,144 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreEnergy.h"
+
+#include <algorithm> // for sort
+#include <cstdio>    // for fopen, fgets, printf
+#include <cstdlib>   // for strtoull
+#include <cstring>   // for strncmp, strchr, strcspn
+
+#if defined(__linux__)
+#include <dirent.h> // for opendir, readdir, closedir
+#endif
+
+#define ENERGY_ZONE_PREFIX "intel-rapl:"
+
+/* First line of a sysfs attribute without the newline */
+static bool energy_read_line(const std::string &path, std::string *value)
+{
+    char line[256];
+    FILE *f = fopen(path.c_str(), "r");
+
+    if (f == nullptr)
+        return false;
+    bool ok = fgets(line, sizeof(line), f) != nullptr;
+    fclose(f);
+    if (ok)
+    {
+        line[strcspn(line, "\r\n")] = 0;
+        *value = line;
+    }
+    return ok;
+}
+
+static bool energy_read_counter(const std::string &path, uint64_t *value)
+{
+    std::string text;
+
+    if (!energy_read_line(path, &text) || text.empty())
+        return false;
+    *value = strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+/* Zones are intel-rapl:P for a package and intel-rapl:P:S for its subzones, on AMD as well */
+static std::vector<std::string> energy_zones(const std::string &root)
+{
+    std::vector<std::string> zones;
+#if defined(__linux__)
+    DIR *dir = opendir(root.c_str());
+    dirent *entry;
+
+    if (dir == nullptr)
+        return zones;
+    while ((entry = readdir(dir)) != nullptr)
+        if (strncmp(entry->d_name, ENERGY_ZONE_PREFIX, strlen(ENERGY_ZONE_PREFIX)) == 0)
+            zones.push_back(entry->d_name);
+    closedir(dir);
+    std::sort(zones.begin(), zones.end());
+#else
+    (void)root;
+#endif
+    return zones;
+}
+
+bool core_energy_open(core_energy *e, const char *root)
+{
+    e->root = root;
+    e->domains.clear();
+    for (const std::string &zone : energy_zones(e->root))
+    {
+        std::string dir = e->root + "/" + zone, name, range;
+        core_energy_domain d = {};
+        bool package = strchr(zone.c_str() + strlen(ENERGY_ZONE_PREFIX), ':') == nullptr;
+
+        if (!energy_read_line(dir + "/name", &name))
+            continue;
+        if (!(package ? (strncmp(name.c_str(), "package", 7) == 0) : (name == "core")))
+            continue;
+        d.path = dir + "/energy_uj";
+        d.package = package;
+        if (!energy_read_counter(d.path, &d.start) || !energy_read_counter(dir + "/max_energy_range_uj", &d.range))
+            continue;
+        /* subzones are named by their package, zone intel-rapl:1:0 belongs to package-1 */
+        if (package)
+            d.name = name;
+        else
+            d.name = "package-" + zone.substr(strlen(ENERGY_ZONE_PREFIX), zone.rfind(':') - strlen(ENERGY_ZONE_PREFIX)) + "/" + name;
+        e->domains.push_back(d);
+    }
+    return !e->domains.empty();
+}
+
+void core_energy_start(core_energy *e)
+{
+    for (core_energy_domain &d : e->domains)
+    {
+        energy_read_counter(d.path, &d.start);
+        d.joules = 0;
+    }
+}
+
+void core_energy_stop(core_energy *e)
+{
+    for (core_energy_domain &d : e->domains)
+    {
+        uint64_t end;
+        if (!energy_read_counter(d.path, &end))
+            continue;
+        /* the counter restarts at 0 after max_energy_range_uj */
+        uint64_t delta = (end >= d.start) ? end - d.start : d.range - d.start + end;
+        d.joules = delta / 1e6;
+    }
+}
+
+void core_energy_report(const core_energy *e, double secs, double iterations)
+{
+    double package = 0;
+
+    if (e->domains.empty())
+    {
+        printf("Energy           : unavailable, no readable RAPL domains in %s\n", e->root.c_str());
+        return;
+    }
+    for (const core_energy_domain &d : e->domains)
+    {
+        printf("Energy           : %s %.3f J, %.3f W, %f iterations/J\n", d.name.c_str(), d.joules, (secs > 0) ? d.joules / secs : 0.0,
+               (d.joules > 0) ? iterations / d.joules : 0.0);
+        if (d.package)
+            package += d.joules;
+    }
+    printf("Energy packages  : %.3f J, %.3f W, %f iterations/J\n", package, (secs > 0) ? package / secs : 0.0, (package > 0) ? iterations / package : 0.0);
+}
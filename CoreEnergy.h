@@ -0,0 +1,45 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* One RAPL zone of the powercap tree, like package-0 or its core subzone */
+struct core_energy_domain
+{
+    std::string name; /* Zone name, prefixed with the package for subzones */
+    std::string path; /* energy_uj file of the zone */
+    uint64_t range;   /* Value at which the counter wraps around, in microjoules */
+    uint64_t start;   /* Counter at core_energy_start */
+    double joules;    /* Energy between core_energy_start and core_energy_stop */
+    bool package;     /* Top level zone, the package domains are summed up for the iterations per joule */
+};
+
+struct core_energy
+{
+    std::string root;
+    std::vector<core_energy_domain> domains;
+};
+
+/* Finds the package and core domains under root with a readable energy counter,
+   returns false if there are none, like on hosts without RAPL or without permission to read it */
+bool core_energy_open(core_energy *e, const char *root);
+void core_energy_start(core_energy *e);
+/* Reads the counters again, a counter that went below its start wrapped around once */
+void core_energy_stop(core_energy *e);
+/* Prints joules, average watts and iterations per joule of every domain */
+void core_energy_report(const core_energy *e, double secs, double iterations);
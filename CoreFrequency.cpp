@@ -0,0 +1,171 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreFrequency.h"
+
+#include "CoreProfile.h" // for core_profile_calibrate, core_ticks_per_sec, CORE_HAS_TSC
+
+#include <chrono> // for milliseconds
+#include <cstdio> // for fopen, fscanf, snprintf
+
+#if defined(__linux__)
+#include <fcntl.h>  // for open
+#include <unistd.h> // for pread, close
+#endif
+
+#define MSR_IA32_MPERF 0xe7
+#define MSR_IA32_APERF 0xe8
+
+/* Reads both counters of the CPU, only on x86 Linux with the msr driver and the permission to read it */
+static bool frequency_read_msr(uint32_t cpu, uint64_t *aperf, uint64_t *mperf)
+{
+#if defined(__linux__) && CORE_HAS_TSC
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/cpu/%u/msr", cpu);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = (pread(fd, aperf, sizeof(*aperf), MSR_IA32_APERF) == sizeof(*aperf)) && (pread(fd, mperf, sizeof(*mperf), MSR_IA32_MPERF) == sizeof(*mperf));
+    close(fd);
+    return ok;
+#else
+    (void)cpu;
+    (void)aperf;
+    (void)mperf;
+    return false;
+#endif
+}
+
+static bool frequency_read_cpufreq(uint32_t cpu, double *khz)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/scaling_cur_freq", cpu);
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+        return false;
+    bool ok = fscanf(f, "%lf", khz) == 1;
+    fclose(f);
+    return ok;
+}
+
+static void frequency_sampler(core_frequency *f)
+{
+    std::unique_lock<std::mutex> guard(f->lock);
+    size_t i;
+
+    while (!f->stop)
+    {
+        for (i = 0; i < f->cpus.size(); i++)
+        {
+            double khz = 0;
+            frequency_read_cpufreq(f->cpus[i], &khz);
+            f->khz[i] += khz;
+        }
+        f->samples++;
+        f->wake.wait_for(guard, std::chrono::milliseconds(f->interval_ms), [f] { return f->stop; });
+    }
+}
+
+void core_frequency_start(core_frequency *f, const std::vector<uint32_t> &cpus, uint32_t interval_ms)
+{
+    double khz;
+    size_t i;
+
+    f->cpus = cpus;
+    f->aperf.assign(cpus.size(), 0);
+    f->mperf.assign(cpus.size(), 0);
+    f->khz.assign(cpus.size(), 0);
+    f->samples = 0;
+    f->interval_ms = interval_ms;
+    f->stop = false;
+
+    f->source = FREQUENCY_MSR;
+    for (i = 0; (i < cpus.size()) && (f->source == FREQUENCY_MSR); i++)
+        if (!frequency_read_msr(cpus[i], &f->aperf[i], &f->mperf[i]))
+            f->source = FREQUENCY_NONE;
+    if (f->source == FREQUENCY_MSR)
+    {
+        /* MPERF counts at the TSC rate, the measured TSC rate turns the ratio into MHz */
+        core_profile_calibrate();
+        for (i = 0; i < cpus.size(); i++)
+            frequency_read_msr(cpus[i], &f->aperf[i], &f->mperf[i]);
+        return;
+    }
+    if (cpus.empty() || !frequency_read_cpufreq(cpus[0], &khz))
+        return;
+    f->source = FREQUENCY_CPUFREQ;
+    f->thrd = std::thread(frequency_sampler, f);
+}
+
+void core_frequency_stop(core_frequency *f)
+{
+    size_t i;
+
+    if (f->source == FREQUENCY_MSR)
+    {
+        for (i = 0; i < f->cpus.size(); i++)
+        {
+            uint64_t aperf = 0, mperf = 0;
+            frequency_read_msr(f->cpus[i], &aperf, &mperf);
+            f->aperf[i] = aperf - f->aperf[i];
+            f->mperf[i] = mperf - f->mperf[i];
+        }
+    }
+    else if (f->source == FREQUENCY_CPUFREQ)
+    {
+        {
+            std::lock_guard<std::mutex> guard(f->lock);
+            f->stop = true;
+        }
+        f->wake.notify_one();
+        f->thrd.join();
+    }
+}
+
+const char *core_frequency_name(const core_frequency *f)
+{
+    switch (f->source)
+    {
+        case FREQUENCY_MSR:
+            return "APERF/MPERF";
+        case FREQUENCY_CPUFREQ:
+            return "scaling_cur_freq";
+        default:
+            return "unavailable";
+    }
+}
+
+static double frequency_cpu_mhz(const core_frequency *f, size_t i)
+{
+    if (f->source == FREQUENCY_MSR)
+        return f->mperf[i] ? core_ticks_per_sec() * f->aperf[i] / f->mperf[i] / 1e6 : 0;
+    if (f->source == FREQUENCY_CPUFREQ)
+        return f->samples ? f->khz[i] / f->samples / 1e3 : 0;
+    return 0;
+}
+
+double core_frequency_mhz(const core_frequency *f, int32_t cpu)
+{
+    double sum = 0;
+    size_t i, count = 0;
+
+    for (i = 0; i < f->cpus.size(); i++)
+    {
+        if ((cpu >= 0) && (f->cpus[i] != (uint32_t)cpu))
+            continue;
+        sum += frequency_cpu_mhz(f, i);
+        count++;
+    }
+    return count ? sum / count : 0;
+}
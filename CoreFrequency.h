@@ -0,0 +1,51 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum core_frequency_source
+{
+    FREQUENCY_NONE,    /* Neither source is readable */
+    FREQUENCY_MSR,     /* APERF/MPERF deltas read from /dev/cpu/N/msr */
+    FREQUENCY_CPUFREQ, /* scaling_cur_freq sampled by a thread */
+};
+
+struct core_frequency
+{
+    core_frequency_source source;
+    std::vector<uint32_t> cpus;
+    std::vector<uint64_t> aperf; /* FREQUENCY_MSR counters at the start, then the deltas */
+    std::vector<uint64_t> mperf;
+    std::vector<double> khz; /* FREQUENCY_CPUFREQ sum of the samples */
+    uint32_t samples;
+    uint32_t interval_ms;
+    /* sampling thread */
+    std::thread thrd;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stop;
+};
+
+/* Starts measuring the frequency of the CPUs, prefers the MSRs and falls back to sampling scaling_cur_freq every interval_ms */
+void core_frequency_start(core_frequency *f, const std::vector<uint32_t> &cpus, uint32_t interval_ms);
+void core_frequency_stop(core_frequency *f);
+const char *core_frequency_name(const core_frequency *f);
+/* Average MHz of the CPU during the measurement, of all measured CPUs for -1, 0 if unknown */
+double core_frequency_mhz(const core_frequency *f, int32_t cpu);
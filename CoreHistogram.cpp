@@ -0,0 +1,94 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreHistogram.h"
+
+#include "CoreListJoin.h" // for core_results
+#include "CoreProfile.h"  // for core_ticks_per_sec
+
+#include <cstdio> // for printf
+#include <memory> // for make_unique
+
+uint64_t histogram_bucket_limit(uint32_t bucket)
+{
+    if (bucket < HISTOGRAM_SUB_COUNT)
+        return bucket;
+    uint32_t shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t base = (uint64_t)(HISTOGRAM_SUB_COUNT + (bucket & (HISTOGRAM_SUB_COUNT - 1))) << shift;
+    return base + (((uint64_t)1 << shift) - 1);
+}
+
+uint64_t histogram_percentile(const core_histogram *h, double percentile)
+{
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5), seen = 0;
+    uint32_t i;
+
+    if (rank == 0)
+        rank = 1;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= rank)
+        {
+            uint64_t limit = histogram_bucket_limit(i);
+            return (limit < h->max) ? limit : h->max;
+        }
+    }
+    return h->max;
+}
+
+void histogram_merge(core_histogram *to, const core_histogram *from)
+{
+    uint32_t i;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+        to->counts[i] += from->counts[i];
+    to->count += from->count;
+    if (from->max > to->max)
+        to->max = from->max;
+}
+
+static void core_histogram_print(const char *prefix, const core_histogram *h)
+{
+    double us = 1e6 / core_ticks_per_sec();
+
+    if (h->count == 0)
+    {
+        printf("%slatency (us)   : no samples\n", prefix);
+        return;
+    }
+    printf("%slatency (us)   : p50 %.3f p90 %.3f p99 %.3f p99.9 %.3f max %.3f (%llu samples)\n", prefix, us * histogram_percentile(h, 50),
+           us * histogram_percentile(h, 90), us * histogram_percentile(h, 99), us * histogram_percentile(h, 99.9), us * h->max,
+           (unsigned long long)h->count);
+}
+
+void core_histogram_report(core_results *results, uint32_t count)
+{
+    auto all = std::make_unique<core_histogram>();
+    char prefix[16];
+    uint32_t i;
+
+    /* per thread, the leader of interleaved contexts has the iterations of the whole group */
+    for (i = 0; i < count; i++)
+    {
+        if (results[i].leader)
+            continue;
+        if (results[i].group > 1)
+            snprintf(prefix, sizeof(prefix), "[%u-%u]", i, i + results[i].group - 1);
+        else
+            snprintf(prefix, sizeof(prefix), "[%u]", i);
+        core_histogram_print(prefix, &results[i].histogram);
+        histogram_merge(all.get(), &results[i].histogram);
+    }
+    core_histogram_print("[all]", all.get());
+}
@@ -0,0 +1,56 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+/* Log-linear buckets: values below 2^HISTOGRAM_SUB_BITS are exact, every further power of two is
+   split into 2^HISTOGRAM_SUB_BITS linear sub-buckets, so the relative error stays below 3.2% */
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+
+struct core_results;
+
+struct core_histogram
+{
+    uint32_t every; /* Record every Nth iteration, 0 disables recording */
+    uint64_t count;
+    uint64_t max;
+    uint64_t counts[HISTOGRAM_BUCKETS];
+};
+
+inline uint32_t histogram_bucket(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_COUNT)
+        return (uint32_t)value;
+    uint32_t shift = (uint32_t)std::bit_width(value) - 1 - HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) + (uint32_t)((value >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+
+inline void histogram_record(core_histogram *h, uint64_t value)
+{
+    h->counts[histogram_bucket(value)]++;
+    h->count++;
+    if (value > h->max)
+        h->max = value;
+}
+
+/* Highest value that falls into the bucket */
+uint64_t histogram_bucket_limit(uint32_t bucket);
+uint64_t histogram_percentile(const core_histogram *h, double percentile);
+void histogram_merge(core_histogram *to, const core_histogram *from);
+void core_histogram_report(core_results *results, uint32_t count);
@@ -0,0 +1,275 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreHistory.h"
+
+#include "CoreIsa.h" // for core_isa_name, core_isa_selected
+
+#include <cmath>   // for exp, fabs, lgamma, log, sqrt
+#include <cstdio>  // for fopen, fgets, fprintf, printf, snprintf, sscanf
+#include <cstring> // for strchr, strlen, strncmp
+#include <ctime>   // for gmtime, strftime, time
+#include <vector>  // for vector
+
+#if defined(__linux__)
+#include <sys/utsname.h> // for uname
+#endif
+
+#if !defined(CORE_BUILD_FLAGS)
+#define CORE_BUILD_FLAGS "unknown"
+#endif
+
+#define HISTORY_BASELINE_RUNS 20
+#define HISTORY_BETA_ITERATIONS 200
+#define HISTORY_MIN_DROP 0.01 /* Relative drop below identical runs that counts as a regression */
+
+/* Value of the first "field : value" line of /proc/cpuinfo */
+static std::string history_cpuinfo(const char *field)
+{
+    char line[1024];
+    std::string value = "unknown";
+    size_t len = strlen(field);
+    FILE *f = fopen("/proc/cpuinfo", "r");
+
+    if (f == nullptr)
+        return value;
+    while (fgets(line, sizeof(line), f))
+    {
+        char *colon = strchr(line, ':');
+        if ((strncmp(line, field, len) != 0) || (colon == nullptr))
+            continue;
+        value = colon + 1;
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r\n") + 1);
+        break;
+    }
+    fclose(f);
+    return value;
+}
+
+/* The history is one line per run with tab separated fields */
+static std::string history_field(std::string value)
+{
+    for (char &c : value)
+        if ((c == '\t') || (c == '\n') || (c == '\r'))
+            c = ' ';
+    return value;
+}
+
+/* The options that change how the contexts run, in a fixed order, so runs in another mode get another key */
+static std::string history_mode(const core_options &opts)
+{
+    std::string mode;
+    size_t i;
+
+    if (opts.processes)
+        mode += " processes";
+    if (opts.interleave > 1)
+        mode += " interleave=" + std::to_string(opts.interleave);
+    if (opts.pin)
+        mode += " pin";
+    if (opts.skip_isolated)
+        mode += " skip-isolated";
+    if (opts.numa != NUMA_POLICY_NONE)
+        mode += std::string(" numa=") + core_numa_name(opts.numa);
+    if (opts.sched != SCHED_POLICY_NONE)
+        mode += std::string(" sched=") + core_sched_name(opts.sched) + ":" + std::to_string((opts.sched == SCHED_POLICY_NICE) ? opts.nice : opts.priority);
+    if (opts.mlock)
+        mode += " mlock";
+    if (opts.prefault)
+        mode += " prefault";
+    if (opts.snapshot || opts.reference || (opts.period > 0))
+        mode += " snapshot";
+    if (opts.profile)
+        mode += " profile=" + std::to_string(opts.profile);
+    if (opts.histogram)
+        mode += " histogram=" + std::to_string(opts.histogram);
+    if (!opts.thread_execs.empty())
+    {
+        mode += " thread-execs=";
+        for (i = 0; i < opts.thread_execs.size(); i++)
+        {
+            if (i > 0)
+                mode += ',';
+            mode += std::to_string(opts.thread_execs[i]);
+        }
+    }
+    if (!opts.thread_seeds.empty())
+    {
+        mode += " thread-seeds=";
+        for (i = 0; i < opts.thread_seeds.size(); i++)
+        {
+            if (i > 0)
+                mode += (i % 3) ? ':' : ',';
+            mode += std::to_string(opts.thread_seeds[i]);
+        }
+    }
+    if (opts.list_layout == LIST_LAYOUT_STRIDED)
+        mode += " list-layout=strided:" + std::to_string(opts.list_stride);
+    else if (opts.list_layout == LIST_LAYOUT_SHUFFLED)
+        mode += " list-layout=shuffled";
+    return mode.empty() ? mode : mode.substr(1);
+}
+
+core_fingerprint core_host_fingerprint(const core_results *res, uint32_t threads, uint32_t blksize, const core_options &opts)
+{
+    core_fingerprint fp;
+    char seeds[64];
+
+    fp.cpu = history_cpuinfo("model name");
+    fp.microcode = history_cpuinfo("microcode");
+#if defined(__linux__)
+    utsname name;
+    fp.kernel = (uname(&name) == 0) ? name.release : "unknown";
+#else
+    fp.kernel = "unknown";
+#endif
+#if defined(__clang__)
+    fp.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    fp.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_FULL_VER)
+    fp.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    fp.compiler = "unknown";
+#endif
+    /* the kernels of another ISA level are another build */
+    fp.flags = std::string(CORE_BUILD_FLAGS) + " isa=" + core_isa_name(core_isa_selected());
+    fp.threads = threads;
+    snprintf(seeds, sizeof(seeds), "0x%x,0x%x,0x%x,%u,0x%x", (uint16_t)res->seed1, (uint16_t)res->seed2, (uint16_t)res->seed3, blksize, res->execs);
+    fp.seeds = seeds;
+    fp.mode = history_mode(opts);
+
+    /* FNV-1a, the default mode keeps the keys of the runs recorded before the mode was part of them */
+    std::string text = fp.cpu + '\n' + fp.microcode + '\n' + fp.kernel + '\n' + fp.compiler + '\n' + fp.flags + '\n' + std::to_string(threads) + '\n' + fp.seeds;
+    if (!fp.mode.empty())
+        text += '\n' + fp.mode;
+    fp.key = 0xcbf29ce484222325ull;
+    for (char c : text)
+        fp.key = (fp.key ^ (uint8_t)c) * 0x100000001b3ull;
+    return fp;
+}
+
+bool core_history_append(const char *path, const core_fingerprint &fp, double score, bool valid)
+{
+    char stamp[32];
+    time_t now = time(nullptr);
+    FILE *f = fopen(path, "a");
+
+    if (f == nullptr)
+        return false;
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    fprintf(f, "key=%016llx\ttime=%s\tscore=%f\tvalid=%d\tthreads=%u\tseeds=%s\tcpu=%s\tmicrocode=%s\tkernel=%s\tcompiler=%s\tflags=%s\tmode=%s\n",
+            (unsigned long long)fp.key, stamp, score, valid ? 1 : 0, fp.threads, fp.seeds.c_str(), history_field(fp.cpu).c_str(),
+            history_field(fp.microcode).c_str(), history_field(fp.kernel).c_str(), history_field(fp.compiler).c_str(), history_field(fp.flags).c_str(),
+            fp.mode.c_str());
+    return fclose(f) == 0;
+}
+
+/* Continued fraction of the incomplete beta function, modified Lentz's method */
+static double history_beta_fraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1, d = 1 - (a + b) * x / (a + 1), h;
+    int m;
+
+    d = 1 / ((fabs(d) < tiny) ? tiny : d);
+    h = d;
+    for (m = 1; m <= HISTORY_BETA_ITERATIONS; m++)
+    {
+        double num = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)), delta;
+        d = 1 + num * d;
+        c = 1 + num / c;
+        d = 1 / ((fabs(d) < tiny) ? tiny : d);
+        c = (fabs(c) < tiny) ? tiny : c;
+        h *= d * c;
+        num = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+        d = 1 + num * d;
+        c = 1 + num / c;
+        d = 1 / ((fabs(d) < tiny) ? tiny : d);
+        c = (fabs(c) < tiny) ? tiny : c;
+        delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1) < 1e-12)
+            break;
+    }
+    return h;
+}
+
+/* Regularized incomplete beta function I_x(a, b) */
+static double history_incomplete_beta(double a, double b, double x)
+{
+    double front;
+
+    if (x <= 0)
+        return 0;
+    if (x >= 1)
+        return 1;
+    front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x));
+    if (x < (a + 1) / (a + b + 2))
+        return front * history_beta_fraction(a, b, x) / a;
+    return 1 - front * history_beta_fraction(b, a, 1 - x) / b;
+}
+
+/* P(T > t) for Student's t distribution with df degrees of freedom */
+static double history_t_tail(double t, double df)
+{
+    double tail = 0.5 * history_incomplete_beta(df / 2, 0.5, df / (df + t * t));
+    return (t > 0) ? tail : 1 - tail;
+}
+
+bool core_history_compare(const char *path, const core_fingerprint &fp, double score, double significance)
+{
+    std::vector<double> runs;
+    unsigned long long key;
+    double value, mean = 0, var = 0, t, p;
+    char line[4096];
+    int valid;
+    size_t i, n;
+    FILE *f = fopen(path, "r");
+
+    if (f != nullptr)
+    {
+        while (fgets(line, sizeof(line), f))
+            if ((sscanf(line, "key=%llx\ttime=%*s\tscore=%lf\tvalid=%d", &key, &value, &valid) == 3) && (key == fp.key) && valid)
+                runs.push_back(value);
+        fclose(f);
+    }
+    if (runs.size() > HISTORY_BASELINE_RUNS)
+        runs.erase(runs.begin(), runs.end() - HISTORY_BASELINE_RUNS);
+    n = runs.size();
+    if (n < 2)
+    {
+        printf("Regression test  : %u valid runs with key %016llx in the history, at least 2 are needed\n", (uint32_t)n, (unsigned long long)fp.key);
+        return false;
+    }
+
+    for (i = 0; i < n; i++)
+        mean += runs[i] / n;
+    for (i = 0; i < n; i++)
+        var += (runs[i] - mean) * (runs[i] - mean) / (n - 1);
+    /* one sided test of the new score against the prediction interval of the history */
+    if (var > 0)
+    {
+        t = (mean - score) / sqrt(var * (1 + 1.0 / n));
+        p = history_t_tail(t, (double)(n - 1));
+    }
+    else /* identical runs have no spread to test against, only a drop beyond the timer resolution counts */
+        p = (score < mean * (1 - HISTORY_MIN_DROP)) ? 0 : 1;
+
+    bool regression = p < significance;
+    printf("Regression test  : %f vs %f +- %f over %u runs, %+.2f%%, p %.4g, %s\n", score, mean, sqrt(var), (uint32_t)n, 100 * (score - mean) / mean, p,
+           regression ? "significant regression" : "no significant regression");
+    return regression;
+}
@@ -0,0 +1,41 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include "CoreOptions.h"
+#include <cstdint>
+#include <string>
+
+/* Everything a score depends on besides the code, runs are only compared to runs with the same key */
+struct core_fingerprint
+{
+    std::string cpu;       /* model name from /proc/cpuinfo */
+    std::string microcode; /* microcode revision from /proc/cpuinfo */
+    std::string kernel;    /* kernel release */
+    std::string compiler;  /* compiler version */
+    std::string flags;     /* build type and compiler flags */
+    uint32_t threads;      /* number of threads or processes, the contexts of a thread are in the mode */
+    std::string seeds;     /* seed1, seed2, seed3, size and execs */
+    std::string mode;      /* options that change the score, empty for the defaults */
+    uint64_t key;          /* hash of all the fields above */
+};
+
+core_fingerprint core_host_fingerprint(const core_results *res, uint32_t threads, uint32_t blksize, const core_options &opts);
+/* Appends one line with the fingerprint and the score to the history file */
+bool core_history_append(const char *path, const core_fingerprint &fp, double score, bool valid);
+/* Tests the score against the valid runs in the history with the same key,
+   returns true if it is significantly lower at the significance level */
+bool core_history_compare(const char *path, const core_fingerprint &fp, double score, double significance);
@@ -0,0 +1,142 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreInterference.h"
+
+#include "CoreIsa.h"    // for core_isa
+#include "CoreSystem.h" // for core_allowed_cpus, core_cpu_siblings
+
+#include <algorithm> // for find
+#include <atomic>    // for atomic
+#include <chrono>    // for steady_clock, duration
+#include <cstdio>    // for printf
+#include <cstdlib>   // for free, malloc
+#include <thread>    // for thread, sleep_for, yield
+#include <vector>    // for vector
+
+struct interference_worker
+{
+    core_results *res;
+    uint32_t cpu;
+    double rate; /* Iterations per second */
+};
+
+static void interference_worker_run(interference_worker *w, const std::atomic<bool> *go, const std::atomic<bool> *stop)
+{
+    core_results *res = w->res;
+    uint64_t count = 0;
+
+    res->cpu = (int32_t)w->cpu;
+    core_setup_thread(res);
+    res->iterations = 1;
+    while (!go->load())
+        std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    while (!stop->load(std::memory_order_relaxed))
+    {
+        core_isa()->iterate(res);
+        count++;
+    }
+    w->rate = count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Runs all workers at the same time for secs seconds */
+static void interference_measure(interference_worker *workers, uint32_t count, double secs)
+{
+    std::atomic<bool> go{false}, stop{false};
+    std::vector<std::thread> threads;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        threads.emplace_back(interference_worker_run, &workers[i], &go, &stop);
+    go = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+    stop = true;
+    for (i = 0; i < count; i++)
+        threads[i].join();
+}
+
+static void interference_matrix(const char *name, core_results *ctx, uint32_t cpu, uint32_t other, const double *solo, double secs)
+{
+    uint32_t a, b;
+
+    printf("%-17s: cpu %u and %u, slowdown of the row workload next to the column workload\n", name, cpu, other);
+    printf("                 :");
+    for (b = 0; b < NUM_WORKLOADS; b++)
+        printf(" %8s", workloads[b].name);
+    printf("\n");
+    for (a = 0; a < NUM_WORKLOADS; a++)
+    {
+        printf("  %-15s:", workloads[a].name);
+        for (b = 0; b < NUM_WORKLOADS; b++)
+        {
+            interference_worker pair[2] = {{&ctx[a], cpu, 0}, {&ctx[NUM_WORKLOADS + b], other, 0}};
+            interference_measure(pair, 2, secs);
+            printf(" %8.3f", solo[a] / pair[0].rate);
+        }
+        printf("\n");
+    }
+}
+
+void core_interference_run(const core_results *proto, uint32_t blksize, double secs)
+{
+    /* two contexts per workload, so a workload can run next to itself */
+    std::vector<core_results> ctx(2 * NUM_WORKLOADS);
+    std::vector<uint32_t> cpus = core_allowed_cpus(), siblings;
+    double solo[NUM_WORKLOADS];
+    uint32_t i, cpu = cpus[0];
+    int32_t sibling = -1, other = -1;
+
+    for (i = 0; i < 2 * NUM_WORKLOADS; i++)
+    {
+        core_results *res = &ctx[i];
+        res->seed1 = proto->seed1;
+        res->seed2 = proto->seed2;
+        res->seed3 = proto->seed3;
+        res->execs = workload_mask(i % NUM_WORKLOADS);
+        res->size = blksize / workload_shares(res->execs);
+        res->memblock[0] = malloc(blksize);
+        core_init_context(res);
+    }
+
+    siblings = core_cpu_siblings(cpu);
+    for (uint32_t c : cpus)
+    {
+        bool shared = std::find(siblings.begin(), siblings.end(), c) != siblings.end();
+        if ((c != cpu) && shared && (sibling < 0))
+            sibling = (int32_t)c;
+        if (!shared && (other < 0))
+            other = (int32_t)c;
+    }
+
+    printf("Interference     : %.3f secs per run\n", secs);
+    for (i = 0; i < NUM_WORKLOADS; i++)
+    {
+        interference_worker w = {&ctx[i], cpu, 0};
+        interference_measure(&w, 1, secs);
+        solo[i] = w.rate;
+        printf("Solo %-12s: %f iterations/sec on cpu %u\n", workloads[i].name, solo[i], cpu);
+    }
+    if (sibling >= 0)
+        interference_matrix("Sibling CPUs", ctx.data(), cpu, (uint32_t)sibling, solo, secs);
+    else
+        printf("Sibling CPUs     : none allowed for cpu %u\n", cpu);
+    if (other >= 0)
+        interference_matrix("Non-sibling CPUs", ctx.data(), cpu, (uint32_t)other, solo, secs);
+    else
+        printf("Non-sibling CPUs : none allowed for cpu %u\n", cpu);
+
+    for (i = 0; i < 2 * NUM_WORKLOADS; i++)
+        free(ctx[i].memblock[0]);
+}
@@ -0,0 +1,22 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Runs every workload alone and next to every other workload on a sibling and on a non-sibling CPU
+   for secs seconds each, and reports the slowdown against the solo run as a matrix */
+void core_interference_run(const core_results *proto, uint32_t blksize, double secs);
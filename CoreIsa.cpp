@@ -0,0 +1,221 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreIsa.h"
+
+#include "CoreListJoin.h" // for core_results, core_start_parallel, core_stop_parallel, core_calibrate, iterate, core_snapshot_restore
+#include "CoreMatrix.h"   // for core_matrix_type_run
+#include "CoreState.h"    // for core_bench_state
+
+#include <chrono>  // for steady_clock
+#include <cstdio>  // for printf
+#include <cstring> // for strcmp
+#include <vector>  // for vector
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h> // for __get_cpuid, __get_cpuid_count
+#define CORE_ISA_CPUID 1
+#else
+#define CORE_ISA_CPUID 0
+#endif
+
+/* CMake defines CORE_ISA_X86_64_VN for every level it could compile */
+#if defined(CORE_ISA_X86_64_V2)
+namespace core_x86_64_v2
+{
+extern const core_isa_kernels isa_kernels;
+}
+#endif
+#if defined(CORE_ISA_X86_64_V3)
+namespace core_x86_64_v3
+{
+extern const core_isa_kernels isa_kernels;
+}
+#endif
+#if defined(CORE_ISA_X86_64_V4)
+namespace core_x86_64_v4
+{
+extern const core_isa_kernels isa_kernels;
+}
+#endif
+
+static const core_isa_kernels baseline_kernels = {core_start_parallel, core_stop_parallel, core_calibrate, iterate, core_bench_state, workloads, core_matrix_type_run};
+
+static const core_isa_kernels *isa_table[NUM_ISA_LEVELS] = {
+    &baseline_kernels,
+#if defined(CORE_ISA_X86_64_V2)
+    &core_x86_64_v2::isa_kernels,
+#else
+    nullptr,
+#endif
+#if defined(CORE_ISA_X86_64_V3)
+    &core_x86_64_v3::isa_kernels,
+#else
+    nullptr,
+#endif
+#if defined(CORE_ISA_X86_64_V4)
+    &core_x86_64_v4::isa_kernels,
+#else
+    nullptr,
+#endif
+};
+
+static const char *isa_names[NUM_ISA_LEVELS] = {"baseline", "x86-64-v2", "x86-64-v3", "x86-64-v4"};
+
+static core_isa_level isa_selected = ISA_BASELINE;
+
+#if CORE_ISA_CPUID
+/* Feature bits of the psABI levels, the AVX levels also need the OS to save the wider registers */
+static bool isa_cpu_supports(core_isa_level level)
+{
+    unsigned eax, ebx, ecx, edx, ext_ecx = 0, leaf7_ebx = 0, xcr0_lo = 0, xcr0_hi = 0;
+
+    if (level == ISA_BASELINE)
+        return true;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    unsigned ecx1 = ecx;
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx))
+        ext_ecx = ecx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        leaf7_ebx = ebx;
+    if (ecx1 & (1u << 27)) /* OSXSAVE */
+        __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+
+    /* SSE3, SSSE3, CMPXCHG16B, SSE4.1, SSE4.2, POPCNT and LAHF/SAHF */
+    const unsigned v2 = (1u << 0) | (1u << 9) | (1u << 13) | (1u << 19) | (1u << 20) | (1u << 23);
+    if (((ecx1 & v2) != v2) || !(ext_ecx & 1u))
+        return false;
+    if (level == ISA_X86_64_V2)
+        return true;
+
+    /* FMA, MOVBE, F16C, AVX, then BMI1, AVX2, BMI2 and LZCNT, with the XMM and YMM state enabled */
+    const unsigned v3 = (1u << 12) | (1u << 22) | (1u << 28) | (1u << 29), v3_leaf7 = (1u << 3) | (1u << 5) | (1u << 8);
+    if (((ecx1 & v3) != v3) || ((leaf7_ebx & v3_leaf7) != v3_leaf7) || !(ext_ecx & (1u << 5)) || ((xcr0_lo & 0x6) != 0x6))
+        return false;
+    if (level == ISA_X86_64_V3)
+        return true;
+
+    /* AVX512F, DQ, CD, BW and VL, with the opmask and ZMM state enabled */
+    const unsigned v4_leaf7 = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+    return ((leaf7_ebx & v4_leaf7) == v4_leaf7) && ((xcr0_lo & 0xe6) == 0xe6);
+}
+#else
+static bool isa_cpu_supports(core_isa_level level)
+{
+    return level == ISA_BASELINE;
+}
+#endif
+
+const char *core_isa_name(core_isa_level level)
+{
+    return isa_names[level];
+}
+
+bool core_isa_parse(const char *text, core_isa_level *level)
+{
+    static const char *short_names[NUM_ISA_LEVELS] = {"v1", "v2", "v3", "v4"};
+    uint32_t i;
+
+    for (i = 0; i < NUM_ISA_LEVELS; i++)
+    {
+        if ((strcmp(text, isa_names[i]) == 0) || (strcmp(text, short_names[i]) == 0))
+        {
+            *level = (core_isa_level)i;
+            return true;
+        }
+    }
+    if (strcmp(text, "x86-64") == 0)
+    {
+        *level = ISA_BASELINE;
+        return true;
+    }
+    return false;
+}
+
+bool core_isa_available(core_isa_level level)
+{
+    return (isa_table[level] != nullptr) && isa_cpu_supports(level);
+}
+
+core_isa_level core_isa_best(void)
+{
+    uint32_t i;
+
+    for (i = NUM_ISA_LEVELS - 1; i > ISA_BASELINE; i--)
+        if (core_isa_available((core_isa_level)i))
+            return (core_isa_level)i;
+    return ISA_BASELINE;
+}
+
+void core_isa_select(core_isa_level level)
+{
+    isa_selected = level;
+}
+
+core_isa_level core_isa_selected(void)
+{
+    return isa_selected;
+}
+
+const core_isa_kernels *core_isa(void)
+{
+    return isa_table[isa_selected];
+}
+
+void core_isa_scores(core_results *results, uint32_t count, double secs)
+{
+    std::vector<uint16_t> crcs;
+    double baseline = 0;
+    uint32_t i, level, probes, w;
+
+    for (level = 0; level < NUM_ISA_LEVELS; level++)
+    {
+        const core_isa_kernels *k = isa_table[level];
+        if (!core_isa_available((core_isa_level)level))
+        {
+            printf("ISA score        : %s not available\n", isa_names[level]);
+            continue;
+        }
+        uint32_t iterations = k->calibrate(results, count, secs, &probes);
+        for (i = 0; i < count; i++)
+            results[i].iterations = iterations;
+        for (i = 0; i < count; i++)
+            core_snapshot_restore(&results[i]);
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < count; i++)
+            k->start_parallel(&results[i]);
+        for (i = 0; i < count; i++)
+            k->stop_parallel(&results[i]);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = (elapsed > 0) ? count * (double)iterations / elapsed : 0;
+
+        /* every level computes the same CRCs, the first iteration of each context is compared */
+        bool same = true;
+        for (i = 0; i < count; i++)
+        {
+            for (w = 0; w < NUM_WORKLOADS; w++)
+            {
+                if (crcs.size() < (size_t)count * NUM_WORKLOADS)
+                    crcs.push_back(results[i].crcs[w]);
+                else if (crcs[i * NUM_WORKLOADS + w] != results[i].crcs[w])
+                    same = false;
+            }
+        }
+        if (baseline == 0)
+            baseline = rate;
+        printf("ISA score        : %s %f iterations/sec, %.3fx baseline%s\n", isa_names[level], rate, (baseline > 0) ? rate / baseline : 0.0,
+               same ? "" : ", ERROR! CRCs differ from the baseline");
+    }
+}
@@ -0,0 +1,57 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMatrix.h"   // for core_matrix_type
+#include "CoreWorkload.h" // for core_workload
+#include <cstdint>
+
+struct core_results;
+
+/* The baseline is the build of the benchmark itself, x86-64-v1 unless the build flags say otherwise */
+enum core_isa_level
+{
+    ISA_BASELINE,
+    ISA_X86_64_V2,
+    ISA_X86_64_V3,
+    ISA_X86_64_V4,
+    NUM_ISA_LEVELS,
+};
+
+/* Entry points of one build of the kernels */
+struct core_isa_kernels
+{
+    void (*start_parallel)(core_results *res);
+    void (*stop_parallel)(core_results *res);
+    uint32_t (*calibrate)(core_results *results, uint32_t count, double secs, uint32_t *probes);
+    void (*iterate)(core_results *res);
+    uint16_t (*bench_state)(uint32_t blksize, uint8_t *memblock, int16_t seed1, int16_t seed2, int16_t step, uint16_t crc);
+    const core_workload *workloads; /* Registry with the bench functions of this build */
+    uint16_t (*matrix_type_run)(core_matrix_type type, uint32_t blksize, void *memblk, int32_t seed, uint32_t iterations, uint16_t *first, uint32_t *N);
+};
+
+const char *core_isa_name(core_isa_level level);
+/* Accepts the names and v1 to v4, returns false for anything else */
+bool core_isa_parse(const char *text, core_isa_level *level);
+/* The level is compiled into the binary and CPUID reports all its features */
+bool core_isa_available(core_isa_level level);
+/* Highest available level */
+core_isa_level core_isa_best(void);
+void core_isa_select(core_isa_level level);
+core_isa_level core_isa_selected(void);
+/* Kernels of the selected level */
+const core_isa_kernels *core_isa(void);
+/* Runs all contexts for about secs seconds with every available level and prints the iterations per second of each */
+void core_isa_scores(core_results *results, uint32_t count, double secs);
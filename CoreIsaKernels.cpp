@@ -0,0 +1,26 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/* Compiled only into the ISA level builds, where CORE_KERNEL puts the kernels into their own namespace */
+#include "CoreIsa.h"
+#include "CoreListJoin.h" // for core_start_parallel, core_stop_parallel, core_calibrate, iterate
+#include "CoreMatrix.h"   // for core_matrix_type_run
+#include "CoreState.h"    // for core_bench_state
+
+CORE_KERNEL_BEGIN
+
+extern const core_isa_kernels isa_kernels;
+const core_isa_kernels isa_kernels = {core_start_parallel, core_stop_parallel, core_calibrate, iterate, core_bench_state, workloads, core_matrix_type_run};
+
+CORE_KERNEL_END
@@ -0,0 +1,28 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+/* The kernel sources are compiled once into the global namespace for the benchmark, and again with
+   CORE_KERNEL set to a namespace name for other builds of the same code in the same binary. Only
+   functions and the workload registry are wrapped, the data types are shared by all builds. */
+#if defined(CORE_KERNEL)
+#define CORE_KERNEL_BEGIN \
+    namespace CORE_KERNEL \
+    {
+#define CORE_KERNEL_END }
+#else
+#define CORE_KERNEL_BEGIN
+#define CORE_KERNEL_END
+#endif
@@ -18,11 +18,25 @@ Original Author: Shay Gal-on
 
 #include "CoreListJoin.h"
 
-#include "CoreMatrix.h" // for core_bench_matrix
-#include "CoreState.h"  // for core_bench_state
-#include "CoreUtil.h"   // for crcu16, crc16
-
-#include <utility> // for move
+#include "CoreProfile.h"  // for core_profile_call
+#include "CoreSystem.h"   // for core_pin_thread, core_set_scheduler, core_current_node, core_alloc_block, core_thread_usage
+#include "CoreTrace.h"    // for core_trace_record
+#include "CoreUtil.h"     // for crcu16, crc16
+#include "CoreWorkload.h" // for workloads, for_each_workload
+
+#include <algorithm> // for clamp, max, sort
+#include <chrono>    // for steady_clock
+#include <cstdlib>   // for free, malloc
+#include <cstring>   // for memcpy
+#include <numeric>   // for gcd
+#include <utility>   // for move, swap
+#include <vector>    // for vector
+
+CORE_KERNEL_BEGIN
+
+#define CALIBRATE_MIN_SECS 0.01
+#define CALIBRATE_PROBE_SECS 0.05
+#define CALIBRATE_RATE_PROBES 3
 
 list_head *core_list_find(list_head *list, list_data *info);
 list_head *core_list_reverse(list_head *list);
@@ -45,25 +59,22 @@ int16_t calc_func(int16_t *pdata, core_results *res)
         int16_t flag = data & 0x7;
         int16_t dtype = ((data >> 3) & 0xf);
         dtype |= dtype << 4;
-        switch (flag)
-        {
-            case 0:
-                if (dtype < 0x22)
-                    dtype = 0x22;
-                retval = core_bench_state(res->size, (uint8_t *)res->memblock[3], res->seed1, res->seed2, dtype, res->crc);
-                if (res->crcstate == 0)
-                    res->crcstate = retval;
-                break;
-            case 1:
-                retval = core_bench_matrix(&(res->mat), dtype, res->crc);
-                if (res->crcmatrix == 0)
-                    res->crcmatrix = retval;
-                break;
-            default:
-                retval = data;
-                break;
-        }
-        res->crc = crcu16(retval, res->crc);
+        retval = data;
+        for_each_workload([&](auto w) {
+            constexpr uint32_t index = decltype(w)::value;
+            if constexpr (workloads[index].dispatch == DISPATCH_CALC)
+            {
+                if ((flag == workloads[index].calc_flag) && (res->execs & workload_mask(index)))
+                {
+                    retval = core_profile_call(&res->profile, index, [&] { return workloads[index].bench(res, dtype); });
+                    if (res->trace)
+                        core_trace_record(res->trace, index, dtype, res->crc, retval);
+                    if (res->crcs[index] == 0)
+                        res->crcs[index] = retval;
+                }
+            }
+        });
+        res->crc = core_profile_call(&res->profile, PROFILE_CRC, [&] { return crcu16(retval, res->crc); });
         retval &= 0x007f;
         *pdata = (data & 0xff00) | 0x0080 | retval;
         return retval;
@@ -93,53 +104,40 @@ void copy_info(list_data *to, list_data *from)
     to->idx = from->idx;
 }
 
-uint16_t core_bench_list(core_results *res, int16_t finder_idx)
+/* Moves the item after the one found to the front of the reversed list */
+static void core_list_found(list_head *list, list_head *this_find, uint16_t *retval, uint16_t *found, uint16_t *missed)
 {
-    uint16_t retval = 0;
-    uint16_t found = 0, missed = 0;
-    list_head *list = res->list;
-    int16_t find_num = res->seed3;
-    list_head *this_find;
-    list_head *finder, *remover;
-    list_data info = {0, 0};
-    int16_t i;
+    list_head *finder;
 
-    info.idx = finder_idx;
-    for (i = 0; i < find_num; i++)
+    if (this_find == nullptr)
     {
-        info.data16 = (i & 0xff);
-        this_find = core_list_find(list, &info);
-        list = core_list_reverse(list);
-        if (this_find == nullptr)
-        {
-            missed++;
-            retval += (list->next->info->data16 >> 8) & 1;
-        }
-        else
+        (*missed)++;
+        *retval += (list->next->info->data16 >> 8) & 1;
+    }
+    else
+    {
+        (*found)++;
+        if (this_find->info->data16 & 0x1)
+            *retval += (this_find->info->data16 >> 9) & 1;
+        if (this_find->next != nullptr)
         {
-            found++;
-            if (this_find->info->data16 & 0x1)
-                retval += (this_find->info->data16 >> 9) & 1;
-            if (this_find->next != nullptr)
-            {
-                finder = this_find->next;
-                this_find->next = finder->next;
-                finder->next = list->next;
-                list->next = finder;
-            }
+            finder = this_find->next;
+            this_find->next = finder->next;
+            finder->next = list->next;
+            list->next = finder;
         }
-        if (info.idx >= 0)
-            info.idx++;
-
-#if CORE_DEBUG
-        printf("List find %d: [%d,%d,%d]\n", i, retval, missed, found);
-#endif
     }
-    retval += found * 4 - missed;
+}
+
+/* Sorts the list after the finds and folds it into the CRC */
+static uint16_t core_list_check(core_results *res, list_head *list, list_data *info, int16_t finder_idx, uint16_t retval)
+{
+    list_head *finder, *remover;
+
     if (finder_idx > 0)
         list = core_list_mergesort(list, cmp_complex, res);
     remover = core_list_remove(list->next);
-    finder = core_list_find(list, &info);
+    finder = core_list_find(list, info);
     if (!finder)
         finder = list->next;
     while (finder)
@@ -164,13 +162,235 @@ uint16_t core_bench_list(core_results *res, int16_t finder_idx)
     return retval;
 }
 
-list_head *core_list_init(uint32_t blksize, list_head *memblock, int16_t seed)
+uint16_t core_bench_list(core_results *res, int16_t finder_idx)
+{
+    uint16_t retval = 0;
+    uint16_t found = 0, missed = 0;
+    list_head *list = res->list;
+    int16_t find_num = res->seed3;
+    list_head *this_find;
+    list_data info = {0, 0};
+    int16_t i;
+
+    info.idx = finder_idx;
+    for (i = 0; i < find_num; i++)
+    {
+        info.data16 = (i & 0xff);
+        this_find = core_list_find(list, &info);
+        list = core_list_reverse(list);
+        core_list_found(list, this_find, &retval, &found, &missed);
+        if (info.idx >= 0)
+            info.idx++;
+
+#if CORE_DEBUG
+        printf("List find %d: [%d,%d,%d]\n", i, retval, missed, found);
+#endif
+    }
+    retval += found * 4 - missed;
+    return core_list_check(res, list, &info, finder_idx, retval);
+}
+
+void core_bench_list_group(core_results **group, uint32_t count, int16_t finder_idx, uint16_t *crcs)
+{
+    uint16_t found[CORE_MAX_INTERLEAVE] = {}, missed[CORE_MAX_INTERLEAVE] = {};
+    list_head *lists[CORE_MAX_INTERLEAVE], *cursor[CORE_MAX_INTERLEAVE], *rest[CORE_MAX_INTERLEAVE], *reversed[CORE_MAX_INTERLEAVE];
+    list_data info[CORE_MAX_INTERLEAVE];
+    int16_t i, find_num = 0;
+    uint32_t c, pending;
+
+    for (c = 0; c < count; c++)
+    {
+        crcs[c] = 0;
+        lists[c] = group[c]->list;
+        info[c] = {0, finder_idx};
+        find_num = std::max(find_num, group[c]->seed3);
+    }
+    for (i = 0; i < find_num; i++)
+    {
+        /* contexts with fewer finds are done and get no cursors */
+        for (c = 0; c < count; c++)
+        {
+            cursor[c] = nullptr;
+            if (i < group[c]->seed3)
+            {
+                info[c].data16 = (i & 0xff);
+                cursor[c] = lists[c];
+            }
+        }
+        /* every step loads the next node of all lists, none depends on another */
+        do
+        {
+            pending = 0;
+            for (c = 0; c < count; c++)
+            {
+                list_head *p = cursor[c];
+                if (p && ((info[c].idx >= 0) ? (p->info->idx != info[c].idx) : ((p->info->data16 & 0xff) != info[c].data16)))
+                {
+                    cursor[c] = p->next;
+                    pending++;
+                }
+            }
+        } while (pending);
+        /* cursor holds the item found or nullptr, rest walks the lists for the reversal */
+        for (c = 0; c < count; c++)
+        {
+            rest[c] = (i < group[c]->seed3) ? lists[c] : nullptr;
+            reversed[c] = nullptr;
+        }
+        do
+        {
+            pending = 0;
+            for (c = 0; c < count; c++)
+            {
+                list_head *p = rest[c];
+                if (p)
+                {
+                    rest[c] = p->next;
+                    p->next = reversed[c];
+                    reversed[c] = p;
+                    pending++;
+                }
+            }
+        } while (pending);
+        for (c = 0; c < count; c++)
+        {
+            if (i >= group[c]->seed3)
+                continue;
+            lists[c] = reversed[c];
+            core_list_found(lists[c], cursor[c], &crcs[c], &found[c], &missed[c]);
+            if (info[c].idx >= 0)
+                info[c].idx++;
+        }
+    }
+    for (c = 0; c < count; c++)
+    {
+        crcs[c] += found[c] * 4 - missed[c];
+        crcs[c] = core_list_check(group[c], lists[c], &info[c], finder_idx, crcs[c]);
+    }
+}
+
+void core_init_context(core_results *res)
+{
+    uint32_t i, offset = 0;
+
+    for (i = 0; i < NUM_WORKLOADS; i++)
+    {
+        if (workload_mask(i) & res->execs)
+        {
+            uint32_t blksize = res->size * workloads[i].share;
+            res->memblock[i + 1] = (char *)(res->memblock[0]) + offset;
+            offset += blksize;
+            workloads[i].init(res, blksize, res->memblock[i + 1]);
+        }
+    }
+}
+
+bool core_snapshot_take(core_results *res)
+{
+    core_snapshot *s = &res->snapshot;
+
+    s->size = (size_t)res->size * workload_shares(res->execs);
+    s->data = malloc(s->size);
+    if (!s->data)
+        return false;
+    memcpy(s->data, res->memblock[0], s->size);
+    s->list = res->list;
+    s->mat = res->mat;
+    s->chase = res->chase;
+    return true;
+}
+
+void core_snapshot_restore(core_results *res)
+{
+    const core_snapshot *s = &res->snapshot;
+
+    if (!s->data)
+        return;
+    memcpy(res->memblock[0], s->data, s->size);
+    res->list = s->list;
+    res->mat = s->mat;
+    res->chase = s->chase;
+}
+
+void core_snapshot_free(core_results *res)
+{
+    free(res->snapshot.data);
+    res->snapshot.data = nullptr;
+}
+
+void workload_list_init(core_results *res, uint32_t blksize, void *memblk)
+{
+    res->list = core_list_init(blksize, (list_head *)memblk, res->seed1, res->layout, &res->stride);
+}
+
+uint16_t workload_list_bench(core_results *res, int16_t)
+{
+    uint16_t crc;
+    crc = core_bench_list(res, 1);
+    res->crc = crcu16(crc, res->crc);
+    crc = core_bench_list(res, -1);
+    res->crc = crcu16(crc, res->crc);
+    return res->crc;
+}
+
+/* Moves node i of the heads and of the data to slot order[i] and rewrites the pointers,
+   so only the addresses change and every traversal visits the same values in the same order */
+static list_head *core_list_relocate(list_head *list, list_head *heads, list_data *datas, uint32_t count, const std::vector<uint32_t> &order)
+{
+    std::vector<list_head> h(heads, heads + count);
+    std::vector<list_data> d(datas, datas + count);
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        heads[order[i]].next = h[i].next ? &heads[order[h[i].next - heads]] : nullptr;
+        heads[order[i]].info = &datas[order[h[i].info - datas]];
+        datas[order[i]] = d[i];
+    }
+    return &heads[order[list - heads]];
+}
+
+static std::vector<uint32_t> core_list_order(uint32_t count, core_list_layout layout, uint32_t *stride, int16_t seed)
+{
+    std::vector<uint32_t> order(count);
+    uint32_t rnd = (uint32_t)seed, i, j;
+
+    for (i = 0; i < count; i++)
+        order[i] = i;
+    if (layout == LIST_LAYOUT_STRIDED)
+    {
+        /* a stride coprime to the count visits every slot once, the caller gets the one used; the walk only
+           depends on the stride modulo the count */
+        if (count > 0)
+            *stride %= count;
+        *stride = std::max(*stride, 1u);
+        while (std::gcd(*stride, count) != 1)
+            (*stride)++;
+        for (i = 0; i < count; i++)
+            order[i] = (uint32_t)(((uint64_t)i * *stride) % count);
+    }
+    else if (layout == LIST_LAYOUT_SHUFFLED)
+    {
+        /* Fisher-Yates with the generator of the chase ring */
+        for (i = count - 1; (count > 1) && (i > 0); i--)
+        {
+            rnd = rnd * 1103515245 + 12345;
+            j = (rnd >> 8) % (i + 1);
+            std::swap(order[i], order[j]);
+        }
+    }
+    return order;
+}
+
+list_head *core_list_init(uint32_t blksize, list_head *memblock, int16_t seed, core_list_layout layout, uint32_t *stride)
 {
     uint32_t per_item = 16 + sizeof(list_data);
     uint32_t size = (blksize / per_item) - 2;
     list_head *memblock_end = memblock + size;
     list_data *datablock = (list_data *)(memblock_end);
     list_data *datablock_end = datablock + size;
+    list_head *heads = memblock;
+    list_data *datas = datablock;
     uint32_t i;
     list_head *finder, *list = memblock;
     list_data info{0, 0};
@@ -206,6 +426,14 @@ list_head *core_list_init(uint32_t blksize, list_head *memblock, int16_t seed)
         finder = finder->next;
     }
     list = core_list_mergesort(list, cmp_idx, nullptr);
+    /* the nodes used so far are the first ones of both arrays */
+    if (layout != LIST_LAYOUT_SEQUENTIAL)
+    {
+        uint32_t used = (uint32_t)(datablock - datas), distance = stride ? *stride : 1;
+        list = core_list_relocate(list, heads, datas, used, core_list_order(used, layout, &distance, seed));
+        if (stride)
+            *stride = distance;
+    }
 #if CORE_DEBUG
     printf("Initialized list:\n");
     finder = list;
@@ -378,34 +606,218 @@ list_head *core_list_mergesort(list_head *list, list_cmp cmp, core_results *res)
     }
 }
 
+/* One iteration of workload index on res */
+template <uint32_t index> static void iterate_workload(core_results *res, uint32_t i)
+{
+    if constexpr (workloads[index].dispatch == DISPATCH_ITERATE)
+    {
+        if (res->execs & workload_mask(index))
+        {
+            uint16_t crc = core_profile_call(&res->profile, index, [&] { return workloads[index].bench(res, 0); });
+            if (i == 0)
+                res->crcs[index] = crc;
+        }
+    }
+    else if ((res->execs & workload_mask(index)) && !(res->execs & workload_mask(WORKLOAD_LIST)))
+    {
+        /* nothing dispatches to calc_func without the list, so run once per iteration
+           with the dtype calc_func derives from 4 data bits */
+        int16_t dtype = (int16_t)(i & 0xf);
+        dtype |= dtype << 4;
+        uint16_t crc = core_profile_call(&res->profile, index, [&] { return workloads[index].bench(res, dtype); });
+        res->crc = crcu16(crc, res->crc);
+        if (i == 0)
+            res->crcs[index] = crc;
+    }
+}
+
 void iterate(core_results *res)
 {
     uint32_t i;
-    uint16_t crc;
     uint32_t iterations = res->iterations;
     res->crc = 0;
-    res->crclist = 0;
-    res->crcmatrix = 0;
-    res->crcstate = 0;
+    for (i = 0; i < NUM_WORKLOADS; i++)
+        res->crcs[i] = 0;
 
     for (i = 0; i < iterations; i++)
     {
-        crc = core_bench_list(res, 1);
-        res->crc = crcu16(crc, res->crc);
-        crc = core_bench_list(res, -1);
-        res->crc = crcu16(crc, res->crc);
-        if (i == 0)
-            res->crclist = res->crc;
+        bool sample = res->histogram.every && ((i % res->histogram.every) == 0);
+        uint64_t start = sample ? core_ticks_start() : 0;
+        core_profile_iteration(&res->profile, i);
+        for_each_workload([&](auto w) { iterate_workload<decltype(w)::value>(res, i); });
+        if (sample)
+            histogram_record(&res->histogram, core_ticks_stop() - start);
+    }
+}
+
+/* workload_list_bench of every context of the group with the list enabled */
+static void iterate_list_group(core_results *group, uint32_t count, uint32_t i)
+{
+    core_results *lists[CORE_MAX_INTERLEAVE];
+    uint16_t crcs[CORE_MAX_INTERLEAVE];
+    uint32_t c, n = 0;
+
+    for (c = 0; c < count; c++)
+        if (group[c].execs & workload_mask(WORKLOAD_LIST))
+            lists[n++] = &group[c];
+    if (n == 0)
+        return;
+    /* the time of the interleaved traversals goes to the leader */
+    core_profile_call(&group[0].profile, WORKLOAD_LIST, [&] {
+        core_bench_list_group(lists, n, 1, crcs);
+        for (c = 0; c < n; c++)
+            lists[c]->crc = crcu16(crcs[c], lists[c]->crc);
+        core_bench_list_group(lists, n, -1, crcs);
+        for (c = 0; c < n; c++)
+            lists[c]->crc = crcu16(crcs[c], lists[c]->crc);
+        return 0;
+    });
+    for (c = 0; (i == 0) && (c < n); c++)
+        lists[c]->crcs[WORKLOAD_LIST] = lists[c]->crc;
+}
+
+void iterate_group(core_results *group, uint32_t count)
+{
+    uint32_t i, c;
+    uint32_t iterations = group[0].iterations;
+    for (c = 0; c < count; c++)
+    {
+        group[c].crc = 0;
+        for (i = 0; i < NUM_WORKLOADS; i++)
+            group[c].crcs[i] = 0;
+    }
+
+    for (i = 0; i < iterations; i++)
+    {
+        bool sample = group[0].histogram.every && ((i % group[0].histogram.every) == 0);
+        uint64_t start = sample ? core_ticks_start() : 0;
+        for (c = 0; c < count; c++)
+            core_profile_iteration(&group[c].profile, i);
+        /* the workloads of one context still run in the registry order */
+        for_each_workload([&](auto w) {
+            constexpr uint32_t index = decltype(w)::value;
+            if constexpr (index == WORKLOAD_LIST)
+                iterate_list_group(group, count, i);
+            else
+            {
+                for (c = 0; c < count; c++)
+                    iterate_workload<index>(&group[c], i);
+            }
+        });
+        /* an iteration of the group is one sample of the thread, kept by the leader */
+        if (sample)
+            histogram_record(&group[0].histogram, core_ticks_stop() - start);
     }
 }
 
+void core_setup_thread(core_results *res)
+{
+    if ((res->cpu >= 0) && !core_pin_thread((uint32_t)res->cpu))
+        res->cpu = -1;
+    res->sched_ok = core_set_scheduler(res->sched, res->priority);
+}
+
+static void core_init_worker(core_results *res, size_t blksize)
+{
+    if (res->cpu >= 0)
+        core_pin_thread((uint32_t)res->cpu);
+    res->node = core_current_node();
+    res->memblock[0] = core_alloc_block(blksize, res->numa);
+    if (res->memblock[0] != nullptr)
+        core_init_context(res);
+}
+
+void core_init_parallel(core_results *results, uint32_t count, size_t blksize)
+{
+    std::vector<std::thread> threads;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        threads.emplace_back(core_init_worker, &results[i], blksize);
+    for (i = 0; i < count; i++)
+        threads[i].join();
+}
+
+static void core_worker(core_results *res)
+{
+    core_usage before, after;
+
+    core_setup_thread(res);
+    res->usage_ok = core_thread_usage(&before);
+    auto start = std::chrono::steady_clock::now();
+    if (res->group > 1)
+        iterate_group(res, res->group);
+    else
+        iterate(res);
+    res->time = std::chrono::steady_clock::now() - start;
+    res->usage_ok = res->usage_ok && core_thread_usage(&after);
+    res->usage = core_usage_delta(before, after);
+}
+
 void core_start_parallel(core_results *res)
 {
-    std::thread t(iterate, res);
+    /* the thread of the leader runs the other contexts of a group */
+    if (res->leader)
+        return;
+    std::thread t(core_worker, res);
     res->thrd = std::move(t);
 }
 
 void core_stop_parallel(core_results *res)
 {
-    res->thrd.join();
+    if (res->leader)
+    {
+        res->time = res->leader->time;
+        res->usage = res->leader->usage;
+        res->usage_ok = res->leader->usage_ok;
+    }
+    else
+        res->thrd.join();
 }
+
+/* Runs the same number of iterations on all contexts at once and returns the time of the slowest one */
+static double core_probe(core_results *results, uint32_t count, uint32_t iterations)
+{
+    double secs = 0;
+    uint32_t i;
+
+    /* every probe starts from the initialized data when the contexts have snapshots */
+    for (i = 0; i < count; i++)
+        core_snapshot_restore(&results[i]);
+    for (i = 0; i < count; i++)
+    {
+        results[i].iterations = iterations;
+        core_start_parallel(&results[i]);
+    }
+    for (i = 0; i < count; i++)
+    {
+        core_stop_parallel(&results[i]);
+        secs = std::max(secs, time_in_secs(results[i].time));
+    }
+    return secs;
+}
+
+uint32_t core_calibrate(core_results *results, uint32_t count, double secs, uint32_t *probes)
+{
+    uint32_t i, iterations = 1;
+    double probe, times[CALIBRATE_RATE_PROBES];
+
+    /* geometric probes until thread startup and timer resolution are small against the probe */
+    *probes = 1;
+    while (((probe = core_probe(results, count, iterations)) < CALIBRATE_MIN_SECS) && (iterations < UINT32_MAX / 2))
+    {
+        iterations *= 2;
+        (*probes)++;
+    }
+
+    /* the median of a few longer probes measures the rate of all contexts running together */
+    iterations = (uint32_t)std::max(1.0, iterations * CALIBRATE_PROBE_SECS / std::max(probe, 1e-9));
+    for (i = 0; i < CALIBRATE_RATE_PROBES; i++)
+        times[i] = core_probe(results, count, iterations);
+    *probes += CALIBRATE_RATE_PROBES;
+    std::sort(times, times + CALIBRATE_RATE_PROBES);
+    probe = times[CALIBRATE_RATE_PROBES / 2];
+    return (uint32_t)std::clamp(iterations * secs / std::max(probe, 1e-9), 1.0, (double)UINT32_MAX);
+}
+
+CORE_KERNEL_END
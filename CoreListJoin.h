@@ -18,10 +18,22 @@ Original Author: Shay Gal-on
 
 #pragma once
 
+#include "CoreChase.h"
+#include "CoreHistogram.h"
+#include "CoreKernel.h"
+#include "CoreListLayout.h"
 #include "CoreMatrix.h"
+#include "CoreProfile.h"
+#include "CoreSystem.h"
+#include "CoreTime.h"
+#include "CoreTrace.h"
+#include "CoreWorkload.h"
 #include <cstdint>
 #include <thread>
 
+/* Most contexts one thread runs interleaved */
+#define CORE_MAX_INTERLEAVE 16
+
 struct list_data
 {
     int16_t data16;
@@ -34,30 +46,78 @@ struct list_head
     list_data *info;
 };
 
+/* Copy of a freshly initialized context. The block is restored in place, so the pointers the workloads
+   keep into it stay valid and only the ones the benchmark moves are saved with it. */
+struct core_snapshot
+{
+    void *data;  /* Copy of the workload slices of memblock[0], nullptr without a snapshot */
+    size_t size; /* Bytes of the copy */
+    list_head *list;
+    mat_params mat;
+    chase_params chase;
+};
+
 struct core_results
 {
     /* inputs */
-    int16_t seed1;       /* Initializing seed */
-    int16_t seed2;       /* Initializing seed */
-    int16_t seed3;       /* Initializing seed */
-    void *memblock[4];   /* Pointer to safe memory location */
-    uint32_t size;       /* Size of the data */
-    uint32_t iterations; /* Number of iterations to execute */
-    uint32_t execs;      /* Bitmask of operations to execute */
+    int16_t seed1;                     /* Initializing seed */
+    int16_t seed2;                     /* Initializing seed */
+    int16_t seed3;                     /* Initializing seed */
+    void *memblock[1 + NUM_WORKLOADS]; /* Pointer to safe memory location, then one slice per workload */
+    uint32_t size;                     /* Size of the data */
+    uint32_t iterations;               /* Number of iterations to execute */
+    uint32_t execs;                    /* Bitmask of operations to execute */
+    int32_t cpu;                       /* CPU to pin the context to, -1 to let the OS decide */
+    core_sched_policy sched;           /* Scheduling policy of the worker */
+    int32_t priority;                  /* Real-time priority, or the nice value for SCHED_POLICY_NICE */
+    core_numa_policy numa;             /* Placement of memblock[0] */
+    core_list_layout layout;           /* Placement of the list nodes */
+    uint32_t stride;                   /* Distance in nodes for LIST_LAYOUT_STRIDED, the one used after the init */
     list_head *list;
     mat_params mat;
+    chase_params chase;
+    core_trace *trace;    /* calc_func appends every dispatch when set */
+    core_snapshot snapshot;
+    core_results *leader; /* Context whose thread runs this one interleaved with its own, nullptr for a thread of its own */
+    uint32_t group;       /* Number of contexts the thread of a leader interleaves, itself included */
     /* outputs */
     uint16_t crc;
-    uint16_t crclist;
-    uint16_t crcmatrix;
-    uint16_t crcstate;
+    uint16_t crcs[NUM_WORKLOADS]; /* CRC of the first iteration of each workload */
     int16_t err;
+    bool sched_ok;   /* The scheduling policy took effect */
+    int32_t node;    /* NUMA node the context was initialized on, -1 if unknown */
+    CORE_TICKS time; /* Time spent in iterate */
+    core_profile profile;
+    core_histogram histogram; /* Duration of the iterations in ticks */
+    core_usage usage;         /* OS counters of the worker thread during iterate */
+    bool usage_ok;            /* The OS reports thread counters */
     /* execution thread */
     std::thread thrd;
 };
 
-list_head *core_list_init(uint32_t blksize, list_head *memblock, int16_t seed);
+CORE_KERNEL_BEGIN
+
+void core_init_context(core_results *res);
+/* Copies the initialized memory block and pointers of the context, returns false if the copy cannot be allocated */
+bool core_snapshot_take(core_results *res);
+/* Puts the context back to the state of its snapshot, does nothing without one */
+void core_snapshot_restore(core_results *res);
+void core_snapshot_free(core_results *res);
+/* Allocates blksize bytes for every context and initializes it in its own thread, pinned to the CPU
+   of the context if it has one, so the pages are first touched on the node that runs the measured worker.
+   A context whose block cannot be allocated is left with a null memblock[0] */
+void core_init_parallel(core_results *results, uint32_t count, size_t blksize);
+void core_setup_thread(core_results *res);
+list_head *core_list_init(uint32_t blksize, list_head *memblock, int16_t seed, core_list_layout layout = LIST_LAYOUT_SEQUENTIAL, uint32_t *stride = nullptr);
 uint16_t core_bench_list(core_results *res, int16_t finder_idx);
+/* core_bench_list of count contexts, the finds and reversals of all lists advance one node per step */
+void core_bench_list_group(core_results **group, uint32_t count, int16_t finder_idx, uint16_t *crcs);
 void iterate(core_results *res);
+/* iterate of count consecutive contexts in one thread, with the list traversals interleaved */
+void iterate_group(core_results *group, uint32_t count);
 void core_start_parallel(core_results *res);
 void core_stop_parallel(core_results *res);
+/* Returns the iterations that make all contexts running together take secs seconds */
+uint32_t core_calibrate(core_results *results, uint32_t count, double secs, uint32_t *probes);
+
+CORE_KERNEL_END
@@ -0,0 +1,23 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+/* Placement of the list nodes in their block, the logical list is the same for all */
+enum core_list_layout
+{
+    LIST_LAYOUT_SEQUENTIAL, /* In insertion order, as CoreMark allocates them */
+    LIST_LAYOUT_STRIDED,    /* Consecutive insertions a fixed number of nodes apart */
+    LIST_LAYOUT_SHUFFLED,   /* Seeded random permutation */
+};
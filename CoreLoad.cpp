@@ -0,0 +1,97 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreLoad.h"
+
+#include "CoreIsa.h" // for core_isa
+
+#include <chrono> // for steady_clock, duration
+#include <cstdio> // for printf
+#include <thread> // for thread, sleep_until
+#include <vector> // for vector
+
+using load_clock = std::chrono::steady_clock;
+using load_secs = std::chrono::duration<double>;
+
+struct load_worker
+{
+    core_results *res;
+    uint64_t iterations;
+    uint64_t slices;
+    uint64_t overruns; /* Slices that ended before the target of the slice was reached */
+    double busy;       /* Seconds spent in iterate */
+    double elapsed;
+};
+
+static void load_worker_run(load_worker *w, double secs, double duty, double rate, double slice)
+{
+    core_results *res = w->res;
+    load_clock::time_point start, slice_end, now, before;
+
+    core_setup_thread(res);
+    res->iterations = 1;
+    start = slice_end = now = load_clock::now();
+    while (load_secs(now - start).count() < secs)
+    {
+        slice_end += std::chrono::duration_cast<load_clock::duration>(load_secs(slice));
+        /* the targets are cumulative from the start, so a slice that fell short is made up in the next ones
+           and the sleeps to absolute slice ends do not accumulate drift */
+        double end = load_secs(slice_end - start).count();
+        while (((rate > 0) ? (w->iterations < rate * end) : (w->busy < duty * end)) && (now < slice_end))
+        {
+            before = now;
+            core_isa()->iterate(res);
+            now = load_clock::now();
+            w->busy += load_secs(now - before).count();
+            w->iterations++;
+        }
+        w->overruns += (now >= slice_end);
+        w->slices++;
+        if (now < slice_end)
+            std::this_thread::sleep_until(slice_end);
+        now = load_clock::now();
+    }
+    w->elapsed = load_secs(now - start).count();
+}
+
+void core_load_run(core_results *results, uint32_t count, double secs, double duty, double rate, double slice_ms)
+{
+    std::vector<load_worker> workers(count);
+    std::vector<std::thread> threads;
+    double busy = 0, elapsed = 0, iterations = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        workers[i].res = &results[i];
+        threads.emplace_back(load_worker_run, &workers[i], secs, duty, rate, slice_ms / 1000);
+    }
+    for (i = 0; i < count; i++)
+        threads[i].join();
+
+    if (rate > 0)
+        printf("Load target      : %.3f iterations/sec per context, %.3f ms slices\n", rate, slice_ms);
+    else
+        printf("Load target      : %.2f%% utilization per context, %.3f ms slices\n", 100 * duty, slice_ms);
+    for (i = 0; i < count; i++)
+    {
+        load_worker *w = &workers[i];
+        printf("[%u]load          : %.2f%% utilization, %.3f iterations/sec, %llu of %llu slices overrun\n", i, 100 * w->busy / w->elapsed,
+               w->iterations / w->elapsed, (unsigned long long)w->overruns, (unsigned long long)w->slices);
+        busy += w->busy;
+        elapsed += w->elapsed;
+        iterations += (double)w->iterations;
+    }
+    printf("Load achieved    : %.2f%% utilization, %.3f iterations/sec per context\n", 100 * busy / elapsed, iterations / elapsed);
+}
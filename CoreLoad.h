@@ -0,0 +1,22 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Runs every context for secs seconds in slices of slice_ms milliseconds, working for the duty
+   fraction of each slice or until rate iterations per second are reached, and sleeping for the rest */
+void core_load_run(core_results *results, uint32_t count, double secs, double duty, double rate, double slice_ms);
@@ -16,41 +16,90 @@ limitations under the License.
 Original Author: Shay Gal-on
 */
 
-#include "CoreListJoin.h" // for core_results, core_list_init, core_start_p...
-#include "CoreMatrix.h"   // for core_init_matrix
-#include "CoreState.h"    // for core_init_state
-#include "CoreTime.h"     // for time_in_secs, get_time, start_time, stop_time
-#include "CoreUtil.h"     // for get_seed_args, crc16
-
-#include <cstdint> // for uint16_t, uint32_t, int16_t, int32_t, uint8_t
-#include <cstdio>  // for printf
-#include <cstdlib> // for free, malloc
-#include <thread>  // for thread
-#include <vector>  // for vector
-
-#define ID_LIST (1 << 0)
-#define ID_MATRIX (1 << 1)
-#define ID_STATE (1 << 2)
-#define ALL_ALGORITHMS_MASK (ID_LIST | ID_MATRIX | ID_STATE)
-#define NUM_ALGORITHMS 3
-
-static uint16_t list_known_crc[] = {(uint16_t)0xd4b0, (uint16_t)0x3340, (uint16_t)0x6a79, (uint16_t)0xe714, (uint16_t)0xe3c1};
-static uint16_t matrix_known_crc[] = {(uint16_t)0xbe52, (uint16_t)0x1199, (uint16_t)0x5608, (uint16_t)0x1fd7, (uint16_t)0x0747};
-static uint16_t state_known_crc[] = {(uint16_t)0x5e47, (uint16_t)0x39bf, (uint16_t)0xe5a4, (uint16_t)0x8e3a, (uint16_t)0x8d84};
+#include "CoreEnergy.h"       // for core_energy_open, core_energy_start, core_energy_stop, core_energy_report
+#include "CoreFrequency.h"    // for core_frequency_start, core_frequency_stop, core_frequency_mhz
+#include "CoreHistogram.h"    // for core_histogram_report
+#include "CoreHistory.h"      // for core_host_fingerprint, core_history_append, core_history_compare
+#include "CoreInterference.h" // for core_interference_run
+#include "CoreIsa.h"          // for core_isa, core_isa_best, core_isa_select, core_isa_scores
+#include "CoreListJoin.h"     // for core_results, core_list_init, core_start_p...
+#include "CoreLoad.h"         // for core_load_run
+#include "CoreMatrixTypes.h"  // for core_matrix_types_run
+#include "CoreMetrics.h"      // for core_metrics_write
+#include "CoreNoise.h"        // for core_noise_run
+#include "CoreOptions.h"      // for core_options, parse_options
+#include "CoreProcess.h"      // for core_fork_processes, core_start_processes, core_stop_processes
+#include "CoreProfile.h"      // for core_profile_calibrate, core_profile_report
+#include "CoreReference.h"    // for core_reference_crcs
+#include "CoreSystem.h"       // for core_default_threads, core_read_cgroup, core_peak_rss, core_allowed_cpus, core_isolated_cpus, core_lock_memory, core_prefault, core_free_block
+#include "CoreTime.h"         // for time_in_secs, get_time, start_time, stop_time
+#include "CoreTrace.h"        // for core_trace_write, core_trace_replay
+#include "CoreUtil.h"         // for get_seed_args, crc16
+#include "CoreWorkload.h"     // for workloads, workload_mask, workload_shares
+
+#include <algorithm> // for find, max
+#include <array>     // for array
+#include <chrono>    // for steady_clock, duration
+#include <cstdint>   // for uint16_t, uint32_t, int16_t, int32_t, uint8_t
+#include <cstdio>    // for printf
+#include <thread>    // for thread
+#include <vector>    // for vector
 
 #define get_seed_16(x) (int16_t) get_seed_args(x, argc, argv)
 #define get_seed_32(x) get_seed_args(x, argc, argv)
 
+/* Index of the seeds and size of the context in the known CRC tables, -1 if unknown */
+static int32_t core_known_id(const core_results *res, uint16_t *seedcrc)
+{
+    *seedcrc = 0;
+    *seedcrc = crc16(res->seed1, *seedcrc);
+    *seedcrc = crc16(res->seed2, *seedcrc);
+    *seedcrc = crc16(res->seed3, *seedcrc);
+    *seedcrc = crc16((int16_t)res->size, *seedcrc);
+
+    switch (*seedcrc)
+    {
+        case 0x8a02: /* seed1=0, seed2=0, seed3=0x66, size 2000 per algorithm */
+            return 0;
+        case 0x7b05: /* seed1=0x3415, seed2=0x3415, seed3=0x66, size 2000 per algorithm */
+            return 1;
+        case 0x4eaf: /* seed1=0x8, seed2=0x8, seed3=0x8, size 400 per algorithm */
+            return 2;
+        case 0xe9f5: /* seed1=0, seed2=0, seed3=0x66, size 666 per algorithm */
+            return 3;
+        case 0x18f2: /* seed1=0x3415, seed2=0x3415, seed3=0x66, size 666 per algorithm */
+            return 4;
+        default:
+            return -1;
+    }
+}
+
 int main(int argc, char *argv[])
 {
-    uint32_t i, j = 0, num_algorithms = 0;
-    int32_t known_id = -1, total_errors = 0;
-    uint16_t seedcrc = 0;
+    uint32_t i, w, run;
     CORE_TICKS total_time;
+    core_options opts;
+    bool processes, regression = false;
+
+    if (!parse_options(&argc, argv, &opts))
+        return 1;
+    /* the best kernels CPUID allows, unless a level is forced */
+    core_isa_level isa = core_isa_best();
+    if (opts.isa && (!core_isa_parse(opts.isa, &isa) || !core_isa_available(isa)))
+    {
+        printf("ERROR! ISA level %s is unknown, not built into this binary or not supported by this CPU\n", opts.isa);
+        return 1;
+    }
+    core_isa_select(isa);
+    /* the modes that replace the benchmark run the selected kernels as well, and have no report of their own for it */
+    if (opts.replay || opts.trace || (opts.noise > 0) || (opts.duty > 0) || (opts.rate > 0) || (opts.interference > 0) || (opts.matrix_types > 0))
+        printf("ISA level        : %s, %s\n", core_isa_name(isa), opts.isa ? "forced" : "best supported by CPUID");
+    if (opts.replay)
+        return core_trace_replay(opts.replay, (get_seed_32(4) > 0) ? get_seed_32(4) : 1) ? 0 : 1;
 
-    uint32_t core_count = std::thread::hardware_concurrency();
-    if (core_count == 0)
-        core_count = 1;
+    /* in a container the host CPU count overcommits the cpuset and the cpu.max quota */
+    uint32_t thread_count = opts.threads ? opts.threads : core_default_threads();
+    uint32_t core_count = thread_count * opts.interleave;
 
     auto results = std::vector<core_results>(core_count);
 
@@ -61,10 +110,10 @@ int main(int argc, char *argv[])
 #if CORE_DEBUG
     results[0].iterations = 1;
 #endif
-    results[0].execs = get_seed_32(5);
+    results[0].execs = get_seed_32(5) & (workload_mask(NUM_WORKLOADS) - 1);
     if (results[0].execs == 0)
     {
-        results[0].execs = ALL_ALGORITHMS_MASK;
+        results[0].execs = standard_workloads_mask();
     }
 
     if ((results[0].seed1 == 0) && (results[0].seed2 == 0) && (results[0].seed3 == 0))
@@ -80,189 +129,545 @@ int main(int argc, char *argv[])
         results[0].seed3 = 0x66;
     }
 
+    std::vector<uint32_t> cpus = core_allowed_cpus();
+    uint32_t skipped = 0;
+    if (opts.skip_isolated)
+    {
+        std::vector<uint32_t> isolated = core_isolated_cpus(), kept;
+        for (uint32_t cpu : cpus)
+        {
+            if (std::find(isolated.begin(), isolated.end(), cpu) == isolated.end())
+                kept.push_back(cpu);
+        }
+        skipped = (uint32_t)(cpus.size() - kept.size());
+        if (!kept.empty())
+            cpus = kept;
+    }
+    bool pin = opts.pin || opts.skip_isolated || (opts.noise > 0) || (opts.numa != NUMA_POLICY_NONE);
+    /* more threads than CPUs pins several workers to one CPU */
+    bool stacked = pin && (thread_count > cpus.size());
+    if (stacked && (opts.noise > 0))
+    {
+        printf("ERROR! %u threads for %u allowed CPUs, the OS noise mode needs a CPU of its own for every thread\n", thread_count, (uint32_t)cpus.size());
+        return 1;
+    }
+    if (stacked)
+        printf("%u threads for %u allowed CPUs, the pinned workers share CPUs\n", thread_count, (uint32_t)cpus.size());
+    for (i = 0; i < core_count; i++)
+    {
+        results[i].cpu = pin ? (int32_t)cpus[(i / opts.interleave) % cpus.size()] : -1;
+        results[i].sched = opts.sched;
+        results[i].priority = (opts.sched == SCHED_POLICY_NICE) ? opts.nice : opts.priority;
+    }
+
+    int32_t malloc_override = get_seed_32(7);
+    uint32_t blksize = (malloc_override > 0) ? malloc_override : 2000;
     for (i = 0; i < core_count; i++)
     {
-        int32_t malloc_override = get_seed_16(7);
-        results[i].size = (malloc_override > 0) ? malloc_override : 2000;
-        results[i].memblock[0] = malloc(results[i].size);
+        results[i].size = blksize;
         results[i].seed1 = results[0].seed1;
         results[i].seed2 = results[0].seed2;
         results[i].seed3 = results[0].seed3;
         results[i].err = 0;
         results[i].execs = results[0].execs;
+        results[i].numa = opts.numa;
+        results[i].layout = opts.list_layout;
+        results[i].stride = opts.list_stride;
+        results[i].node = -1;
     }
-
-    for (i = 0; i < NUM_ALGORITHMS; i++)
-    {
-        if ((1 << i) & results[0].execs)
-            num_algorithms++;
-    }
+    /* per context execs and seeds cycle through the lists */
+    bool uniform = opts.thread_execs.empty() && opts.thread_seeds.empty();
     for (i = 0; i < core_count; i++)
-        results[i].size = results[i].size / num_algorithms;
-
-    for (i = 0; i < NUM_ALGORITHMS; i++)
     {
-        uint32_t ctx;
-        if ((1 << i) & results[0].execs)
+        if (!opts.thread_execs.empty())
         {
-            for (ctx = 0; ctx < core_count; ctx++)
-                results[ctx].memblock[i + 1] = (char *)(results[ctx].memblock[0]) + results[0].size * j;
-            j++;
+            results[i].execs = opts.thread_execs[i % opts.thread_execs.size()] & (workload_mask(NUM_WORKLOADS) - 1);
+            if (results[i].execs == 0)
+                results[i].execs = standard_workloads_mask();
+        }
+        if (!opts.thread_seeds.empty())
+        {
+            uint32_t set = 3 * (i % (opts.thread_seeds.size() / 3));
+            results[i].seed1 = (int16_t)opts.thread_seeds[set];
+            results[i].seed2 = (int16_t)opts.thread_seeds[set + 1];
+            results[i].seed3 = (int16_t)opts.thread_seeds[set + 2];
         }
     }
 
     for (i = 0; i < core_count; i++)
+        results[i].size = results[i].size / workload_shares(results[i].execs);
+
+    /* contexts are independent, so the initialization order does not change any CRC */
+    bool serial_init = opts.serial_init && (opts.numa == NUMA_POLICY_NONE);
+    start_time();
+    if (serial_init)
     {
-        if (results[i].execs & ID_LIST)
-        {
-            results[i].list = core_list_init(results[0].size, (list_head *)results[i].memblock[1], results[i].seed1);
-        }
-        if (results[i].execs & ID_MATRIX)
+        for (i = 0; i < core_count; i++)
         {
-            core_init_matrix(results[0].size, results[i].memblock[2], (int32_t)results[i].seed1 | (((int32_t)results[i].seed2) << 16), &(results[i].mat));
+            results[i].memblock[0] = core_alloc_block(blksize, opts.numa);
+            if (results[i].memblock[0] != nullptr)
+                core_init_context(&results[i]);
         }
-        if (results[i].execs & ID_STATE)
+    }
+    else
+        core_init_parallel(results.data(), core_count, blksize);
+    stop_time();
+    bool allocated = true;
+    for (i = 0; i < core_count; i++)
+        if (results[i].memblock[0] == nullptr)
         {
-            core_init_state(results[0].size, results[i].seed1, (uint8_t *)results[i].memblock[3]);
+            printf("[%u]ERROR! Cannot allocate %u bytes for the context\n", i, blksize);
+            allocated = false;
         }
+    if (!allocated)
+    {
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return 1;
     }
+    CORE_TICKS init_time = get_time();
 
-    if (results[0].iterations == 0)
+    if (opts.noise > 0)
     {
-        double secs_passed = 0;
-        uint32_t divisor;
-        results[0].iterations = 1;
-        while (secs_passed < 1)
+        uint32_t execs = ~0u;
+        for (i = 0; i < core_count; i++)
+            execs &= results[i].execs;
+        if (!(execs & workload_mask(WORKLOAD_STATE)))
         {
-            results[0].iterations *= 10;
-            start_time();
-            iterate(&results[0]);
-            stop_time();
-            secs_passed = time_in_secs(get_time());
+            printf("ERROR! OS noise mode runs the state workload, enable it in execs\n");
+            return 1;
         }
+        core_profile_calibrate();
+        core_noise_run(results.data(), core_count, opts.noise, opts.noise_threshold);
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return 0;
+    }
 
-        divisor = (uint32_t)secs_passed;
-        if (divisor == 0)
-            divisor = 1;
-        results[0].iterations *= 1 + 10 / divisor;
+    if ((opts.duty > 0) || (opts.rate > 0))
+    {
+        core_load_run(results.data(), core_count, opts.duration, opts.duty / 100, opts.rate, opts.slice);
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return 0;
     }
 
-    start_time();
+    if (opts.interference > 0)
+    {
+        core_interference_run(&results[0], blksize, opts.interference);
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return 0;
+    }
 
-    for (i = 0; i < core_count; i++)
+    if (opts.matrix_types > 0)
     {
-        results[i].iterations = results[0].iterations;
-        results[i].execs = results[0].execs;
-        core_start_parallel(&results[i]);
+        bool valid = core_matrix_types_run(results.data(), core_count, opts.matrix_types);
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return valid ? 0 : 1;
     }
+
+    if (opts.trace)
+    {
+        if (results[0].iterations == 0)
+            results[0].iterations = 1;
+        bool written = core_trace_write(opts.trace, &results[0], blksize);
+        for (i = 0; i < core_count; i++)
+            core_free_block(results[i].memblock[0], blksize, opts.numa);
+        return written ? 0 : 1;
+    }
+
+    /* consecutive contexts share the thread of the first one */
     for (i = 0; i < core_count; i++)
     {
-        core_stop_parallel(&results[i]);
+        results[i].group = (i % opts.interleave) ? 0 : opts.interleave;
+        results[i].leader = (i % opts.interleave) ? &results[i - i % opts.interleave] : nullptr;
     }
 
-    stop_time();
-    total_time = get_time();
+    /* the ISA scores, every calibration probe and every run start from the initialized data; the reference
+       CRCs are computed from freshly initialized data and every periodic run is validated, so they need it too */
+    bool snapshot = opts.snapshot || opts.reference || (opts.period > 0);
+    for (i = 0; snapshot && (i < core_count); i++)
+        snapshot = core_snapshot_take(&results[i]);
+    for (i = 0; !snapshot && (i < core_count); i++)
+        core_snapshot_free(&results[i]);
 
-    seedcrc = crc16(results[0].seed1, seedcrc);
-    seedcrc = crc16(results[0].seed2, seedcrc);
-    seedcrc = crc16(results[0].seed3, seedcrc);
-    seedcrc = crc16((int16_t)results[0].size, seedcrc);
+    if (opts.isa_scores > 0)
+    {
+        uint32_t iterations = results[0].iterations;
+        core_isa_scores(results.data(), core_count, opts.isa_scores);
+        results[0].iterations = iterations;
+    }
 
-    switch (seedcrc)
+    bool calibrated = results[0].iterations == 0;
+    uint32_t probes = 0;
+    CORE_TICKS calibration_time{};
+    if (calibrated)
     {
-        case 0x8a02: /* seed1=0, seed2=0, seed3=0x66, size 2000 per algorithm */
-            known_id = 0;
-            printf("6k performance run parameters for coremark.\n");
-            break;
-        case 0x7b05: /* seed1=0x3415, seed2=0x3415, seed3=0x66, size 2000 per algorithm */
-            known_id = 1;
-            printf("6k validation run parameters for coremark.\n");
-            break;
-        case 0x4eaf: /* seed1=0x8, seed2=0x8, seed3=0x8, size 400 per algorithm */
-            known_id = 2;
-            printf("Profile generation run parameters for coremark.\n");
-            break;
-        case 0xe9f5: /* seed1=0, seed2=0, seed3=0x66, size 666 per algorithm */
-            known_id = 3;
-            printf("2K performance run parameters for coremark.\n");
-            break;
-        case 0x18f2: /* seed1=0x3415, seed2=0x3415, seed3=0x66, size 666 per algorithm */
-            known_id = 4;
-            printf("2K validation run parameters for coremark.\n");
-            break;
-        default:
-            total_errors = -1;
-            break;
+        start_time();
+        results[0].iterations = core_isa()->calibrate(results.data(), core_count, opts.duration, &probes);
+        stop_time();
+        calibration_time = get_time();
     }
 
-    if (known_id >= 0)
+    for (i = 0; i < core_count; i++)
+        results[i].iterations = results[0].iterations;
+    if (opts.profile || opts.histogram)
+        core_profile_calibrate();
+    bool locked = opts.mlock && core_lock_memory();
+    size_t prefaulted = 0;
+    if (opts.prefault)
+    {
+        for (i = 0; i < core_count; i++)
+            prefaulted += core_prefault(results[i].memblock[0], results[i].size * workload_shares(results[i].execs));
+    }
+    /* contexts with the same seeds, size and execs share one reference run */
+    std::vector<std::array<uint16_t, NUM_WORKLOADS>> reference(core_count);
+    uint32_t reference_runs = 0, reference_cached = 0;
+    for (i = 0; opts.reference && (i < core_count); i++)
     {
+        for (w = 0; w < i; w++)
+            if ((results[w].seed1 == results[i].seed1) && (results[w].seed2 == results[i].seed2) && (results[w].seed3 == results[i].seed3) &&
+                (results[w].size == results[i].size) && (results[w].execs == results[i].execs))
+                break;
+        if (w < i)
+            reference[i] = reference[w];
+        else if (core_reference_crcs(&results[i], opts.reference_cache, reference[i].data()))
+            reference_cached++;
+        else
+            reference_runs++;
+    }
+
+    core_frequency frequency;
+    core_energy energy;
+    if (opts.energy)
+        core_energy_open(&energy, opts.energy);
+
+    for (run = 1;; run++)
+    {
+        auto period_start = std::chrono::steady_clock::now();
+        /* a context whose worker or child never reports must not keep the outputs of the previous run */
         for (i = 0; i < core_count; i++)
         {
+            results[i].crc = 0;
+            for (w = 0; w < NUM_WORKLOADS; w++)
+                results[i].crcs[w] = 0;
+            results[i].time = CORE_TICKS{};
+            results[i].usage = core_usage{};
+            results[i].usage_ok = false;
             results[i].err = 0;
-            if ((results[i].execs & ID_LIST) && (results[i].crclist != list_known_crc[known_id]))
-            {
-                printf("[%u]ERROR! list crc 0x%04x - should be 0x%04x\n", i, results[i].crclist, list_known_crc[known_id]);
-                results[i].err++;
-            }
-            if ((results[i].execs & ID_MATRIX) && (results[i].crcmatrix != matrix_known_crc[known_id]))
+            results[i].profile = core_profile{};
+            results[i].profile.every = opts.profile;
+            results[i].histogram = core_histogram{};
+            results[i].histogram.every = opts.histogram;
+        }
+
+        double restore_secs = 0;
+        if (snapshot)
+        {
+            auto restore_start = std::chrono::steady_clock::now();
+            for (i = 0; i < core_count; i++)
+                core_snapshot_restore(&results[i]);
+            restore_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - restore_start).count();
+        }
+
+        processes = opts.processes && core_fork_processes(results.data(), core_count, opts.mlock);
+
+        core_cgroup cgroup_start, cgroup_stop;
+        bool cgroup = core_read_cgroup(&cgroup_start);
+        if (opts.energy)
+            core_energy_start(&energy);
+        if (opts.frequency)
+            core_frequency_start(&frequency, cpus, opts.frequency);
+        start_time();
+
+        if (processes)
+        {
+            core_start_processes();
+            core_stop_processes(results.data(), core_count);
+        }
+        else
+        {
+            for (i = 0; i < core_count; i++)
+                core_isa()->start_parallel(&results[i]);
+            for (i = 0; i < core_count; i++)
+                core_isa()->stop_parallel(&results[i]);
+        }
+
+        stop_time();
+        total_time = get_time();
+        if (opts.energy)
+            core_energy_stop(&energy);
+        cgroup = cgroup && core_read_cgroup(&cgroup_stop);
+        if (opts.frequency)
+            core_frequency_stop(&frequency);
+
+        /* the banner names the parameter set only when every context runs it */
+        uint16_t seedcrc;
+        int32_t known_id = core_known_id(&results[0], &seedcrc), total_errors = 0;
+        uint32_t mismatches = 0, unvalidated = 0;
+        for (i = 1; (known_id >= 0) && (i < core_count); i++)
+            if (core_known_id(&results[i], &seedcrc) != known_id)
+                known_id = -1;
+        switch (known_id)
+        {
+            case 0:
+                printf("6k performance run parameters for coremark.\n");
+                break;
+            case 1:
+                printf("6k validation run parameters for coremark.\n");
+                break;
+            case 2:
+                printf("Profile generation run parameters for coremark.\n");
+                break;
+            case 3:
+                printf("2K performance run parameters for coremark.\n");
+                break;
+            case 4:
+                printf("2K validation run parameters for coremark.\n");
+                break;
+            default:
+                break;
+        }
+
+        /* every context is validated on its own, the reference CRCs cover any seeds, sizes and execs */
+        for (i = 0; i < core_count; i++)
+        {
+            /* contexts with their own execs or seeds have their own size and seedcrc */
+            uint16_t context_seedcrc;
+            int32_t id = core_known_id(&results[i], &context_seedcrc);
+            bool covered = opts.reference || (id >= 0);
+            for (w = 0; covered && !opts.reference && (w < NUM_WORKLOADS); w++)
+                if ((results[i].execs & workload_mask(w)) && !workload_known_crcs(w, results[i].execs))
+                    covered = false;
+            if (!covered)
             {
-                printf("[%u]ERROR! matrix crc 0x%04x - should be 0x%04x\n", i, results[i].crcmatrix, matrix_known_crc[known_id]);
-                results[i].err++;
+                printf("[%u]Cannot validate operation for seedcrc 0x%04x and execs 0x%x\n", i, context_seedcrc, results[i].execs);
+                unvalidated++;
+                total_errors += results[i].err;
+                continue;
             }
-            if ((results[i].execs & ID_STATE) && (results[i].crcstate != state_known_crc[known_id]))
+            for (w = 0; w < NUM_WORKLOADS; w++)
             {
-                printf("[%u]ERROR! state crc 0x%04x - should be 0x%04x\n", i, results[i].crcstate, state_known_crc[known_id]);
-                results[i].err++;
+                if (!(results[i].execs & workload_mask(w)))
+                    continue;
+                uint16_t known = opts.reference ? reference[i][w] : workload_known_crcs(w, results[i].execs)[id];
+                if (results[i].crcs[w] != known)
+                {
+                    printf("[%u]ERROR! %s crc 0x%04x - should be 0x%04x\n", i, workloads[w].name, results[i].crcs[w], known);
+                    results[i].err++;
+                    mismatches++;
+                }
             }
             total_errors += results[i].err;
         }
-    }
+        /* one context that cannot be validated leaves the whole run unvalidated, unless another one failed */
+        if (unvalidated && (total_errors == 0))
+            total_errors = -1;
 
-    printf("CoreMark Size    : %lu\n", (long unsigned)results[0].size);
-    printf("Total time (secs): %f\n", time_in_secs(total_time));
-    if (time_in_secs(total_time) > 0.0)
-        printf("Iterations/Sec   : %f\n", core_count * results[0].iterations / time_in_secs(total_time));
+        printf("CoreMark Size    : %lu\n", (long unsigned)results[0].size);
+        printf("Total time (secs): %f\n", time_in_secs(total_time));
+        printf("Init time (secs) : %f, %s\n", time_in_secs(init_time), serial_init ? "serial" : "parallel");
+        if (calibrated)
+            printf("Calibration      : %f secs, %u probes for a target of %f secs\n", time_in_secs(calibration_time), probes, opts.duration);
+        if (time_in_secs(total_time) > 0.0)
+            printf("Iterations/Sec   : %f\n", core_count * results[0].iterations / time_in_secs(total_time));
+        if (opts.energy)
+            core_energy_report(&energy, time_in_secs(total_time), (double)core_count * results[0].iterations);
+        if (opts.frequency && (frequency.source == FREQUENCY_NONE))
+            printf("Frequency        : unavailable, neither the msr device nor scaling_cur_freq is readable\n");
+        else if (opts.frequency)
+        {
+            /* per thread, so the contexts interleaved on one thread count for one core */
+            double ratio = 0;
+            uint32_t threads = 0;
+            for (i = 0; i < core_count; i++)
+            {
+                if (results[i].leader)
+                    continue;
+                double mhz = core_frequency_mhz(&frequency, results[i].cpu);
+                double rate = (time_in_secs(results[i].time) > 0) ? std::max(results[i].group, 1u) * results[i].iterations / time_in_secs(results[i].time) : 0;
+                printf("[%u]frequency cpu %-2d: %.0f MHz, %f iterations/sec, %f CoreMark/MHz\n", i, results[i].cpu, mhz, rate, (mhz > 0) ? rate / mhz : 0.0);
+                ratio += (mhz > 0) ? rate / mhz : 0.0;
+                threads++;
+            }
+            printf("CoreMark/MHz     : %f per core, %.0f MHz average from %s\n", threads ? ratio / threads : 0.0, core_frequency_mhz(&frequency, -1),
+                   core_frequency_name(&frequency));
+        }
 
-    if (time_in_secs(total_time) < 10.0)
-    {
-        printf("ERROR! Must execute for at least 10 secs for a valid result!\n");
-        total_errors++;
-    }
+        if (time_in_secs(total_time) < 10.0)
+        {
+            printf("ERROR! Must execute for at least 10 secs for a valid result!\n");
+            if (total_errors >= 0)
+                total_errors++;
+        }
+        /* nr_periods only counts with a quota somewhere in the hierarchy */
+        if (cgroup && ((cgroup_stop.quota > 0) || (cgroup_stop.nr_periods > 0)))
+        {
+            uint64_t throttled = cgroup_stop.nr_throttled - cgroup_start.nr_throttled;
+            if (cgroup_stop.quota > 0)
+                printf("Cgroup cpu.max   : %.2f CPUs, cpuset %u CPUs\n", cgroup_stop.quota, cgroup_stop.cpuset);
+            printf("Cgroup throttled : %llu of %llu periods, %f secs\n", (unsigned long long)throttled,
+                   (unsigned long long)(cgroup_stop.nr_periods - cgroup_start.nr_periods), (cgroup_stop.throttled_usec - cgroup_start.throttled_usec) / 1e6);
+            if (throttled > 0)
+            {
+                printf("ERROR! The cgroup was throttled by its cpu.max quota, use fewer threads for a valid result!\n");
+                if (total_errors >= 0)
+                    total_errors++;
+            }
+        }
 
-    printf("Iterations       : %lu\n", (long unsigned)core_count * results[0].iterations);
-    printf("Parallel threads : %d\n", core_count);
+        printf("Iterations       : %lu\n", (long unsigned)core_count * results[0].iterations);
+        if (processes)
+            printf("Parallel procs   : %d\n", core_count);
+        else
+            printf("Parallel threads : %d\n", thread_count);
+        printf("ISA level        : %s, %s\n", core_isa_name(isa), opts.isa ? "forced" : "best supported by CPUID");
+        if (opts.interleave > 1)
+            printf("Interleaved      : %u contexts per thread, %f iterations/sec per thread\n", opts.interleave,
+                   (time_in_secs(total_time) > 0.0) ? opts.interleave * results[0].iterations / time_in_secs(total_time) : 0.0);
+        if (pin)
+        {
+            uint32_t pinned = 0;
+            for (i = 0; i < core_count; i++)
+                pinned += (results[i].cpu >= 0);
+            if (stacked)
+                printf("Pinned contexts  : %u of %u, %u threads share %u CPUs\n", pinned, core_count, thread_count, (uint32_t)cpus.size());
+            else
+                printf("Pinned contexts  : %u of %u\n", pinned, core_count);
+        }
+        if (opts.skip_isolated)
+            printf("Skipped CPUs     : %u in isolcpus or nohz_full\n", skipped);
+        if (opts.sched != SCHED_POLICY_NONE)
+        {
+            uint32_t applied = 0;
+            for (i = 0; i < core_count; i++)
+                applied += results[i].sched_ok;
+            printf("Scheduling       : %s %s %d, applied in %u of %u contexts\n", core_sched_name(opts.sched),
+                   (opts.sched == SCHED_POLICY_NICE) ? "nice" : "priority", results[0].priority, applied, core_count);
+        }
+        if (opts.list_layout == LIST_LAYOUT_STRIDED)
+            printf("List layout      : strided, %u nodes apart\n", results[0].stride);
+        else if (opts.list_layout == LIST_LAYOUT_SHUFFLED)
+            printf("List layout      : shuffled\n");
+        if (opts.usage)
+        {
+            uint32_t flagged = 0;
+            for (i = 0; i < core_count; i++)
+            {
+                const core_usage *u = &results[i].usage;
+                if (results[i].leader || !results[i].usage_ok)
+                    continue;
+                printf("[%u]usage cpu %-2d: %llu voluntary, %llu involuntary switches, ", i, results[i].cpu, (unsigned long long)u->voluntary,
+                       (unsigned long long)u->involuntary);
+                if (u->migrations_ok)
+                    printf("%llu migrations, ", (unsigned long long)u->migrations);
+                printf("%llu minor, %llu major faults%s\n", (unsigned long long)u->minor_faults, (unsigned long long)u->major_faults,
+                       (u->involuntary > opts.usage) ? ", preempted more than the threshold" : "");
+                flagged += (u->involuntary > opts.usage);
+            }
+            printf("Peak RSS         : %llu KiB\n", (unsigned long long)(processes ? core_peak_rss(true) : core_peak_rss(false)));
+            if (flagged)
+                printf("Preempted threads: %u with more than %u involuntary context switches\n", flagged, opts.usage);
+        }
+        if (opts.reference)
+            printf("Reference CRCs   : %u computed, %u from the cache\n", reference_runs, reference_cached);
+        if (opts.mlock)
+            printf("Memory locking   : mlockall %s\n", locked ? "succeeded" : "failed");
+        if (opts.prefault)
+            printf("Prefaulted pages : %lu\n", (long unsigned)prefaulted);
+        if (snapshot)
+            printf("Snapshot restore : %f usecs for %lu bytes per context\n", restore_secs * 1e6, (long unsigned)results[0].snapshot.size);
+        else if (opts.snapshot)
+            printf("Snapshot restore : cannot allocate the copies, every run continues from the data of the previous one\n");
+        if (opts.numa != NUMA_POLICY_NONE)
+        {
+            printf("NUMA placement   : %s, %u nodes with memory\n", core_numa_name(opts.numa), (uint32_t)core_memory_nodes().size());
+            for (i = 0; i < core_count; i++)
+            {
+                std::vector<uint32_t> pages = core_block_nodes(results[i].memblock[0], blksize);
+                uint32_t node, resident = 0;
+                printf("[%u]numa node     : cpu %d node %d, pages", i, results[i].cpu, results[i].node);
+                for (node = 0; node < pages.size(); node++)
+                {
+                    if (pages[node] > 0)
+                        printf(" node%u %u", node, pages[node]);
+                    resident += pages[node];
+                }
+                printf(resident ? "\n" : " unknown\n");
+            }
+        }
 
-    printf("seedcrc          : 0x%04x\n", seedcrc);
-    if (results[0].execs & ID_LIST)
+        printf("seedcrc          : 0x%04x\n", seedcrc);
+        for (w = 0; w < NUM_WORKLOADS; w++)
+            for (i = 0; i < core_count; i++)
+                if (results[i].execs & workload_mask(w))
+                    printf("[%d]crc%-11s: 0x%04x\n", i, workloads[w].name, results[i].crcs[w]);
         for (i = 0; i < core_count; i++)
-            printf("[%d]crclist       : 0x%04x\n", i, results[i].crclist);
-    if (results[0].execs & ID_MATRIX)
+            printf("[%d]crcfinal      : 0x%04x\n", i, results[i].crc);
         for (i = 0; i < core_count; i++)
-            printf("[%d]crcmatrix     : 0x%04x\n", i, results[i].crcmatrix);
-    if (results[0].execs & ID_STATE)
-        for (i = 0; i < core_count; i++)
-            printf("[%d]crcstate      : 0x%04x\n", i, results[i].crcstate);
-    for (i = 0; i < core_count; i++)
-        printf("[%d]crcfinal      : 0x%04x\n", i, results[i].crc);
+            printf("[%d]time (secs)   : %f\n", i, time_in_secs(results[i].time));
+        if (opts.profile)
+            core_profile_report(results.data(), core_count);
+        if (opts.histogram)
+            core_histogram_report(results.data(), core_count);
+        if ((results[0].execs == workload_mask(WORKLOAD_CHASE)) && (results[0].chase.N > 0))
+        {
+            double loads = 0, secs = 0;
+            for (i = 0; i < core_count; i++)
+            {
+                loads += (double)results[i].iterations * results[i].chase.N;
+                secs += time_in_secs(results[i].time);
+            }
+            printf("Chase ns/load    : %f\n", secs * 1e9 / loads);
+        }
 
-    if (total_errors == 0)
-    {
-        printf("Correct operation validated.\n");
+        if (total_errors == 0)
+        {
+            printf("Correct operation validated.\n");
+
+            if ((known_id == 3) && !(results[0].execs & ~standard_workloads_mask()) && uniform)
+            {
+                printf("CoreMarkCpp : %f\n", core_count * results[0].iterations / time_in_secs(total_time));
+            }
+        }
+
+        if (total_errors > 0)
+            printf("Errors detected\n");
+        if (total_errors < 0)
+            printf("Cannot validate operation for these seed values, please compare with results on a known platform.\n");
+
+        bool valid = (unvalidated == 0) && (total_errors == 0);
 
-        if (known_id == 3)
+        if (opts.history && !valid)
+            printf("History          : invalid run not compared and not appended to %s\n", opts.history);
+        else if (opts.history)
         {
-            printf("CoreMarkCpp : %f\n", core_count * results[0].iterations / time_in_secs(total_time));
+            core_fingerprint fp = core_host_fingerprint(&results[0], thread_count, blksize, opts);
+            double score = core_count * results[0].iterations / time_in_secs(total_time);
+            if (opts.compare)
+                regression = core_history_compare(opts.history, fp, score, opts.significance) || regression;
+            if (core_history_append(opts.history, fp, score, valid))
+                printf("History          : valid run appended to %s with key %016llx\n", opts.history, (unsigned long long)fp.key);
+            else
+                printf("ERROR! Cannot append to the history %s\n", opts.history);
         }
-    }
 
-    if (total_errors > 0)
-        printf("Errors detected\n");
-    if (total_errors < 0)
-        printf("Cannot validate operation for these seed values, please compare with results on a known platform.\n");
+        if (opts.metrics && !core_metrics_write(opts.metrics, results.data(), core_count, blksize, time_in_secs(total_time), valid, mismatches, processes))
+            printf("ERROR! Cannot write the metrics to %s\n", opts.metrics);
+
+        if ((opts.period <= 0) || (opts.runs && (run >= opts.runs)))
+            break;
+        std::this_thread::sleep_until(period_start + std::chrono::duration<double>(opts.period));
+        printf("\n");
+    }
 
     for (i = 0; i < core_count; i++)
-        free(results[i].memblock[0]);
+    {
+        core_snapshot_free(&results[i]);
+        core_free_block(results[i].memblock[0], blksize, opts.numa);
+    }
 
-    return 0;
+    return regression ? 2 : 0;
 }
@@ -18,18 +18,42 @@ Original Author: Shay Gal-on
 
 #include "CoreMatrix.h"
 
+#include "CoreListJoin.h" // for core_results
 #include "CoreUtil.h"
 
+#include <type_traits> // for is_floating_point_v
+
+CORE_KERNEL_BEGIN
+
 #define matrix_test_next(x) (x + 1)
 #define matrix_clip(x, y) ((y) ? (x) & 0x0ff : (x) & 0x0ffff)
 #define matrix_big(x) (0xf000 | (x))
 #define bit_extract(x, from, to) (((x) >> (from)) & (~(0xffffffff << (to))))
 
-/* align an offset to point to a 32b value */
+/* align an offset to point to a 32b value, or to a 64b value for the wider types */
 #define align_mem(x) (void *)(4 + (((intptr_t)(x)-1) & ~3))
+#define align_mem8(x) (void *)(8 + (((intptr_t)(x)-1) & ~7))
+
+/* The bit operations of the kernels go through an integer for the floating point types,
+   for the integer types they are the original expressions */
+template <typename T> static inline auto matrix_bits(T x)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return (int64_t)x;
+    else
+        return x;
+}
+
+template <typename T> static inline T *matrix_align(void *x)
+{
+    if constexpr (alignof(T) > 4)
+        return (T *)align_mem8(x);
+    else
+        return (T *)align_mem(x);
+}
 
 #if CORE_DEBUG
-void printmat(MATDAT *A, uint32_t N, char *name)
+template <typename D> void printmat(D *A, uint32_t N, const char *name)
 {
     uint32_t i, j;
     printf("Matrix %s [%dx%d]:\n", name, N, N);
@@ -39,13 +63,13 @@ void printmat(MATDAT *A, uint32_t N, char *name)
         {
             if (j != 0)
                 printf(",");
-            printf("%d", A[i * N + j]);
+            printf("%g", (double)A[i * N + j]);
         }
         printf("\n");
     }
 }
 
-void printmatC(MATRES *C, uint32_t N, char *name)
+template <typename R> void printmatC(R *C, uint32_t N, const char *name)
 {
     uint32_t i, j;
     printf("Matrix %s [%dx%d]:\n", name, N, N);
@@ -55,7 +79,7 @@ void printmatC(MATRES *C, uint32_t N, char *name)
         {
             if (j != 0)
                 printf(",");
-            printf("%d", C[i * N + j]);
+            printf("%g", (double)C[i * N + j]);
         }
         printf("\n");
     }
@@ -75,10 +99,57 @@ uint16_t core_bench_matrix(mat_params *p, int16_t seed, uint16_t crc)
     return crc;
 }
 
-int16_t matrix_test(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val)
+void workload_matrix_init(core_results *res, uint32_t blksize, void *memblk)
+{
+    core_init_matrix(blksize, memblk, (int32_t)res->seed1 | (((int32_t)res->seed2) << 16), &(res->mat));
+}
+
+uint16_t workload_matrix_bench(core_results *res, int16_t arg)
+{
+    return core_bench_matrix(&(res->mat), arg, res->crc);
+}
+
+template <typename D, typename R> static uint16_t matrix_type_run(uint32_t blksize, void *memblk, int32_t seed, uint32_t iterations, uint16_t *first, uint32_t *N)
+{
+    matrix_params<D, R> p;
+    uint16_t crc = 0;
+    uint32_t i;
+
+    *N = core_init_matrix(blksize, memblk, seed, &p);
+    *first = 0;
+    for (i = 0; i < iterations; i++)
+    {
+        /* the dtype iterate passes to the matrix when the list is disabled */
+        int16_t dtype = (int16_t)(i & 0xf);
+        dtype |= dtype << 4;
+        crc = crc16(matrix_test(p.N, p.C, p.A, p.B, (D)dtype), crc);
+        if (i == 0)
+            *first = crc;
+    }
+    return crc;
+}
+
+uint16_t core_matrix_type_run(core_matrix_type type, uint32_t blksize, void *memblk, int32_t seed, uint32_t iterations, uint16_t *first, uint32_t *N)
+{
+    switch (type)
+    {
+        case MATRIX_INT8:
+            return matrix_type_run<int8_t, int32_t>(blksize, memblk, seed, iterations, first, N);
+        case MATRIX_INT32:
+            return matrix_type_run<int32_t, int64_t>(blksize, memblk, seed, iterations, first, N);
+        case MATRIX_FLOAT:
+            return matrix_type_run<float, float>(blksize, memblk, seed, iterations, first, N);
+        case MATRIX_DOUBLE:
+            return matrix_type_run<double, double>(blksize, memblk, seed, iterations, first, N);
+        default:
+            return matrix_type_run<MATDAT, MATRES>(blksize, memblk, seed, iterations, first, N);
+    }
+}
+
+template <typename D, typename R> int16_t matrix_test(uint32_t N, R *C, D *A, D *B, D val)
 {
     uint16_t crc = 0;
-    MATDAT clipval = matrix_big(val);
+    D clipval = (D)matrix_big(matrix_bits(val));
 
     matrix_add_const(N, A, val); /* make sure data changes  */
 #if CORE_DEBUG
@@ -105,27 +176,28 @@ int16_t matrix_test(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val)
     printmatC(C, N, "matrix_mul_matrix_bitextract");
 #endif
 
-    matrix_add_const(N, A, -val); /* return matrix to initial value */
+    matrix_add_const(N, A, (D)-val); /* return matrix to initial value */
     return crc;
 }
 
-uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, mat_params *p)
+template <typename D, typename R> uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, matrix_params<D, R> *p)
 {
     uint32_t N = 0;
-    MATDAT *A;
-    MATDAT *B;
+    D *A;
+    D *B;
     int32_t order = 1;
-    MATDAT val;
+    D val;
     uint32_t i = 0, j = 0;
     if (seed == 0)
         seed = 1;
+    /* two data matrices and one result matrix, 8 bytes per element for the standard types */
     while (j < blksize)
     {
         i++;
-        j = i * i * 2 * 4;
+        j = i * i * (uint32_t)(2 * sizeof(D) + sizeof(R));
     }
     N = i - 1;
-    A = (MATDAT *)align_mem(memblk);
+    A = matrix_align<D>(memblk);
     B = A + N * N;
 
     for (i = 0; i < N; i++)
@@ -133,11 +205,11 @@ uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, mat_para
         for (j = 0; j < N; j++)
         {
             seed = ((order * seed) % 65536);
-            val = (MATDAT)(seed + order);
-            val = matrix_clip(val, 0);
+            val = (D)(seed + order);
+            val = (D)matrix_clip(matrix_bits(val), 0);
             B[i * N + j] = val;
-            val = (MATDAT)(val + order);
-            val = matrix_clip(val, 1);
+            val = (D)(val + order);
+            val = (D)matrix_clip(matrix_bits(val), 1);
             A[i * N + j] = val;
             order++;
         }
@@ -145,7 +217,7 @@ uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, mat_para
 
     p->A = A;
     p->B = B;
-    p->C = (MATRES *)align_mem(B + N * N);
+    p->C = matrix_align<R>(B + N * N);
     p->N = N;
 #if CORE_DEBUG
     printmat(A, N, "A");
@@ -154,9 +226,9 @@ uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, mat_para
     return N;
 }
 
-int16_t matrix_sum(uint32_t N, MATRES *C, MATDAT clipval)
+template <typename D, typename R> int16_t matrix_sum(uint32_t N, R *C, D clipval)
 {
-    MATRES tmp = 0, prev = 0, cur = 0;
+    R tmp = 0, prev = 0, cur = 0;
     int16_t ret = 0;
     uint32_t i, j;
     for (i = 0; i < N; i++)
@@ -180,19 +252,19 @@ int16_t matrix_sum(uint32_t N, MATRES *C, MATDAT clipval)
     return ret;
 }
 
-void matrix_mul_const(uint32_t N, MATRES *C, MATDAT *A, MATDAT val)
+template <typename D, typename R> void matrix_mul_const(uint32_t N, R *C, D *A, D val)
 {
     uint32_t i, j;
     for (i = 0; i < N; i++)
     {
         for (j = 0; j < N; j++)
         {
-            C[i * N + j] = (MATRES)A[i * N + j] * (MATRES)val;
+            C[i * N + j] = (R)A[i * N + j] * (R)val;
         }
     }
 }
 
-void matrix_add_const(uint32_t N, MATDAT *A, MATDAT val)
+template <typename D> void matrix_add_const(uint32_t N, D *A, D val)
 {
     uint32_t i, j;
     for (i = 0; i < N; i++)
@@ -204,7 +276,7 @@ void matrix_add_const(uint32_t N, MATDAT *A, MATDAT val)
     }
 }
 
-void matrix_mul_vect(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
+template <typename D, typename R> void matrix_mul_vect(uint32_t N, R *C, D *A, D *B)
 {
     uint32_t i, j;
     for (i = 0; i < N; i++)
@@ -212,12 +284,12 @@ void matrix_mul_vect(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
         C[i] = 0;
         for (j = 0; j < N; j++)
         {
-            C[i] += (MATRES)A[i * N + j] * (MATRES)B[j];
+            C[i] += (R)A[i * N + j] * (R)B[j];
         }
     }
 }
 
-void matrix_mul_matrix(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
+template <typename D, typename R> void matrix_mul_matrix(uint32_t N, R *C, D *A, D *B)
 {
     uint32_t i, j, k;
     for (i = 0; i < N; i++)
@@ -227,13 +299,13 @@ void matrix_mul_matrix(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
-                C[i * N + j] += (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
+                C[i * N + j] += (R)A[i * N + k] * (R)B[k * N + j];
             }
         }
     }
 }
 
-void matrix_mul_matrix_bitextract(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
+template <typename D, typename R> void matrix_mul_matrix_bitextract(uint32_t N, R *C, D *A, D *B)
 {
     uint32_t i, j, k;
     for (i = 0; i < N; i++)
@@ -243,9 +315,11 @@ void matrix_mul_matrix_bitextract(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B)
             C[i * N + j] = 0;
             for (k = 0; k < N; k++)
             {
-                MATRES tmp = (MATRES)A[i * N + k] * (MATRES)B[k * N + j];
-                C[i * N + j] += bit_extract(tmp, 2, 4) * bit_extract(tmp, 5, 7);
+                R tmp = (R)A[i * N + k] * (R)B[k * N + j];
+                C[i * N + j] += bit_extract(matrix_bits(tmp), 2, 4) * bit_extract(matrix_bits(tmp), 5, 7);
             }
         }
     }
 }
+
+CORE_KERNEL_END
@@ -18,26 +18,54 @@ Original Author: Shay Gal-on
 
 #pragma once
 
+#include "CoreKernel.h"
 #include <cstdint>
 
 using MATDAT = int16_t;
 using MATRES = int32_t;
 
-struct mat_params
+template <typename D, typename R> struct matrix_params
 {
     int32_t N;
-    MATDAT *A;
-    MATDAT *B;
-    MATRES *C;
+    D *A;
+    D *B;
+    R *C;
 };
 
-int16_t matrix_test(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B, MATDAT val);
-int16_t matrix_sum(uint32_t N, MATRES *C, MATDAT clipval);
-void matrix_mul_const(uint32_t N, MATRES *C, MATDAT *A, MATDAT val);
-void matrix_mul_vect(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B);
-void matrix_mul_matrix(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B);
-void matrix_mul_matrix_bitextract(uint32_t N, MATRES *C, MATDAT *A, MATDAT *B);
-void matrix_add_const(uint32_t N, MATDAT *A, MATDAT val);
+/* The standard CoreMark matrix */
+using mat_params = matrix_params<MATDAT, MATRES>;
+
+/* Element types of the extended matrix mode, each with its accumulation type */
+enum core_matrix_type
+{
+    MATRIX_INT8,   /* int8_t data, int32_t results */
+    MATRIX_INT16,  /* int16_t data, int32_t results, the standard workload */
+    MATRIX_INT32,  /* int32_t data, int64_t results */
+    MATRIX_FLOAT,  /* float data and results */
+    MATRIX_DOUBLE, /* double data and results */
+    NUM_MATRIX_TYPES,
+};
+
+inline const char *core_matrix_type_name(core_matrix_type type)
+{
+    static const char *names[NUM_MATRIX_TYPES] = {"int8", "int16", "int32", "float", "double"};
+    return names[type];
+}
+
+CORE_KERNEL_BEGIN
+
+template <typename D, typename R> int16_t matrix_test(uint32_t N, R *C, D *A, D *B, D val);
+template <typename D, typename R> int16_t matrix_sum(uint32_t N, R *C, D clipval);
+template <typename D, typename R> void matrix_mul_const(uint32_t N, R *C, D *A, D val);
+template <typename D, typename R> void matrix_mul_vect(uint32_t N, R *C, D *A, D *B);
+template <typename D, typename R> void matrix_mul_matrix(uint32_t N, R *C, D *A, D *B);
+template <typename D, typename R> void matrix_mul_matrix_bitextract(uint32_t N, R *C, D *A, D *B);
+template <typename D> void matrix_add_const(uint32_t N, D *A, D val);
+template <typename D, typename R> uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, matrix_params<D, R> *p);
 
-uint32_t core_init_matrix(uint32_t blksize, void *memblk, int32_t seed, mat_params *p);
 uint16_t core_bench_matrix(mat_params *p, int16_t seed, uint16_t crc);
+/* Initializes a matrix of the type in blksize bytes and runs matrix_test with the dtypes of a standalone matrix,
+   returns the CRC of all iterations, the CRC of the first one in first and the size of the matrix in N */
+uint16_t core_matrix_type_run(core_matrix_type type, uint32_t blksize, void *memblk, int32_t seed, uint32_t iterations, uint16_t *first, uint32_t *N);
+
+CORE_KERNEL_END
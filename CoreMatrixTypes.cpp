@@ -0,0 +1,117 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreMatrixTypes.h"
+
+#include "CoreIsa.h"       // for core_isa
+#include "CoreMatrix.h"    // for core_matrix_type, core_matrix_type_name
+#include "CoreReference.h" // for core_reference_matrix_crc
+
+#include <atomic> // for atomic
+#include <chrono> // for steady_clock, duration
+#include <cstdio> // for printf
+#include <thread> // for thread, sleep_for, yield
+#include <vector> // for vector
+
+/* One pass runs matrix_test with every dtype a standalone matrix sees once */
+#define MATRIX_TYPES_PASS 16
+
+struct matrix_types_worker
+{
+    core_results *res;
+    core_matrix_type type;
+    uint32_t blksize;
+    int32_t seed;
+    uint16_t expected; /* Reference CRC of one pass */
+    uint16_t first;    /* CRC of the first iteration */
+    uint32_t N;
+    bool valid;
+    double rate; /* Iterations per second */
+};
+
+static void matrix_types_worker_run(matrix_types_worker *w, const std::atomic<bool> *go, const std::atomic<bool> *stop)
+{
+    const core_isa_kernels *kernels = core_isa();
+    uint64_t passes = 0;
+    uint16_t first;
+
+    core_setup_thread(w->res);
+    w->valid = true;
+    while (!go->load())
+        std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        if (kernels->matrix_type_run(w->type, w->blksize, w->res->memblock[0], w->seed, MATRIX_TYPES_PASS, &first, &w->N) != w->expected)
+            w->valid = false;
+        if (passes == 0)
+            w->first = first;
+        passes++;
+    } while (!stop->load(std::memory_order_relaxed));
+    w->rate = passes * MATRIX_TYPES_PASS / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool core_matrix_types_run(core_results *results, uint32_t count, double secs)
+{
+    std::vector<matrix_types_worker> workers(count);
+    double rates[NUM_MATRIX_TYPES] = {}; /* Multiply-accumulates per second */
+    uint32_t sizes[NUM_MATRIX_TYPES] = {};
+    uint16_t firsts[NUM_MATRIX_TYPES] = {};
+    bool same[NUM_MATRIX_TYPES] = {};
+    bool valid = true;
+    uint32_t i, t;
+
+    for (t = 0; t < NUM_MATRIX_TYPES; t++)
+    {
+        std::atomic<bool> go{false}, stop{false};
+        std::vector<std::thread> threads;
+        for (i = 0; i < count; i++)
+        {
+            /* contexts with the same matrix share one reference run */
+            matrix_types_worker *w = &workers[i];
+            w->res = &results[i];
+            w->type = (core_matrix_type)t;
+            w->blksize = results[i].size * workloads[WORKLOAD_MATRIX].share;
+            w->seed = (int32_t)results[i].seed1 | (((int32_t)results[i].seed2) << 16);
+            if ((i > 0) && (w->blksize == workers[i - 1].blksize) && (w->seed == workers[i - 1].seed))
+                w->expected = workers[i - 1].expected;
+            else
+                w->expected = core_reference_matrix_crc(w->type, w->blksize, w->seed, MATRIX_TYPES_PASS);
+        }
+        for (i = 0; i < count; i++)
+            threads.emplace_back(matrix_types_worker_run, &workers[i], &go, &stop);
+        go = true;
+        std::this_thread::sleep_for(std::chrono::duration<double>(secs));
+        stop = true;
+        for (i = 0; i < count; i++)
+            threads[i].join();
+
+        same[t] = true;
+        for (i = 0; i < count; i++)
+        {
+            /* matrix_mul_vect, matrix_mul_matrix and matrix_mul_matrix_bitextract per iteration */
+            rates[t] += workers[i].rate * (2.0 * workers[i].N + 1) * workers[i].N * workers[i].N;
+            same[t] = same[t] && workers[i].valid;
+        }
+        firsts[t] = workers[0].first;
+        sizes[t] = workers[0].N;
+        valid = valid && same[t];
+    }
+
+    for (t = 0; t < NUM_MATRIX_TYPES; t++)
+        printf("Matrix %-10s: %ux%u, %f M multiply-accumulates/sec, %.3fx int16, crc 0x%04x%s\n", core_matrix_type_name((core_matrix_type)t),
+               sizes[t], sizes[t], rates[t] / 1e6, (rates[MATRIX_INT16] > 0) ? rates[t] / rates[MATRIX_INT16] : 0.0, firsts[t],
+               same[t] ? "" : ", ERROR! CRC differs from the reference");
+    return valid;
+}
@@ -0,0 +1,23 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Runs the matrix workload of every element type in the memory blocks of all contexts at the same time for
+   secs seconds per type, validates every pass against the reference build and reports the throughput.
+   Returns false if a CRC differs from the reference. */
+bool core_matrix_types_run(core_results *results, uint32_t count, double secs);
@@ -0,0 +1,76 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreMetrics.h"
+
+#include <algorithm> // for max
+#include <cstdio>    // for fopen, fprintf, rename, remove, snprintf
+#include <ctime>     // for time
+#include <string>    // for string
+
+static void metrics_family(FILE *f, const char *name, const char *help)
+{
+    fprintf(f, "# TYPE %s gauge\n# HELP %s %s\n", name, name, help);
+}
+
+bool core_metrics_write(const char *path, const core_results *results, uint32_t count, uint32_t blksize, double secs, bool valid, uint32_t mismatches,
+                        bool processes)
+{
+    std::string tmp = std::string(path) + ".tmp";
+    char labels[256];
+    uint32_t i, threads = 0;
+    FILE *f = fopen(tmp.c_str(), "w");
+
+    if (f == nullptr)
+        return false;
+    /* the interleaved contexts of a group run in the thread of their leader */
+    for (i = 0; i < count; i++)
+        if (results[i].leader == nullptr)
+            threads++;
+    snprintf(labels, sizeof(labels), "seeds=\"0x%x,0x%x,0x%x\",size=\"%u\",execs=\"0x%x\",threads=\"%u\",interleave=\"%u\",mode=\"%s\"",
+             (uint16_t)results[0].seed1, (uint16_t)results[0].seed2, (uint16_t)results[0].seed3, blksize, results[0].execs, threads,
+             std::max(results[0].group, 1u), processes ? "processes" : "threads");
+
+    metrics_family(f, "coremark_score", "Iterations per second of all contexts together.");
+    fprintf(f, "coremark_score{%s} %f\n", labels, (secs > 0) ? count * results[0].iterations / secs : 0.0);
+    metrics_family(f, "coremark_thread_iterations_per_second", "Iterations per second of one context.");
+    for (i = 0; i < count; i++)
+    {
+        double thread_secs = time_in_secs(results[i].time);
+        fprintf(f, "coremark_thread_iterations_per_second{%s,thread=\"%u\",cpu=\"%d\"} %f\n", labels, i, results[i].cpu,
+                (thread_secs > 0) ? results[i].iterations / thread_secs : 0.0);
+    }
+    metrics_family(f, "coremark_valid", "1 if the CRCs matched the known values and the run took at least 10 seconds.");
+    fprintf(f, "coremark_valid{%s} %d\n", labels, valid ? 1 : 0);
+    metrics_family(f, "coremark_crc_mismatches", "Number of workload CRCs that did not match the known values.");
+    fprintf(f, "coremark_crc_mismatches{%s} %u\n", labels, mismatches);
+    metrics_family(f, "coremark_duration_seconds", "Duration of the measured phase.");
+    fprintf(f, "coremark_duration_seconds{%s} %f\n", labels, secs);
+    metrics_family(f, "coremark_iterations", "Iterations of every context.");
+    fprintf(f, "coremark_iterations{%s} %u\n", labels, results[0].iterations);
+    metrics_family(f, "coremark_last_run_timestamp_seconds", "Time the run finished.");
+    fprintf(f, "coremark_last_run_timestamp_seconds{%s} %lld\n", labels, (long long)time(nullptr));
+    fprintf(f, "# EOF\n");
+
+    if (fclose(f) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    /* rename does not replace an existing file on Windows */
+    remove(path);
+#endif
+    return rename(tmp.c_str(), path) == 0;
+}
@@ -0,0 +1,23 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Writes the result of a run in the OpenMetrics text format for the node_exporter textfile collector,
+   to a temporary file first that is renamed over path, so the collector never reads a partial file */
+bool core_metrics_write(const char *path, const core_results *results, uint32_t count, uint32_t blksize, double secs, bool valid, uint32_t mismatches,
+                        bool processes);
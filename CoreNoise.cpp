@@ -0,0 +1,136 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreNoise.h"
+
+#include "CoreIsa.h"     // for core_isa
+#include "CoreProfile.h" // for core_ticks_start, core_ticks_stop, core_ticks_per_sec
+#include "CoreSystem.h"  // for core_current_cpu
+
+#include <algorithm> // for sort
+#include <cstdio>    // for printf
+#include <thread>    // for thread
+#include <vector>    // for vector
+
+#define NOISE_CALIBRATION_QUANTA 1000
+#define NOISE_MAX_EVENTS 65536
+#define NOISE_REPORT_EVENTS 20
+
+struct noise_event
+{
+    uint64_t start; /* Ticks since the workers were started */
+    uint64_t noise; /* Ticks above the baseline quantum */
+    int32_t cpu;
+};
+
+struct noise_worker
+{
+    core_results *res;
+    int32_t cpu;
+    bool pinned;
+    uint64_t baseline; /* Shortest quantum during calibration */
+    uint64_t quanta;
+    uint64_t events;
+    uint64_t stolen;
+    uint64_t max;
+    uint64_t elapsed;
+    std::vector<noise_event> log;
+};
+
+static void noise_worker_run(noise_worker *w, uint64_t origin, uint64_t duration, uint64_t threshold)
+{
+    const core_isa_kernels *kernels = core_isa();
+    core_results *res = w->res;
+    uint8_t *block = (uint8_t *)res->memblock[1 + WORKLOAD_STATE];
+    uint32_t blksize = res->size * workloads[WORKLOAD_STATE].share;
+    uint16_t crc = 0;
+    uint64_t start, prev, now, i;
+
+    core_setup_thread(res);
+    w->pinned = res->cpu >= 0;
+    w->cpu = core_current_cpu();
+    w->log.reserve(NOISE_MAX_EVENTS);
+
+    w->baseline = UINT64_MAX;
+    for (i = 0; i < NOISE_CALIBRATION_QUANTA; i++)
+    {
+        prev = core_ticks_start();
+        crc = kernels->bench_state(blksize, block, res->seed1, res->seed2, 0x22, crc);
+        now = core_ticks_stop();
+        if (now - prev < w->baseline)
+            w->baseline = now - prev;
+    }
+
+    /* consecutive timestamps, so the time between two quanta is accounted as well */
+    start = prev = core_ticks_start();
+    do
+    {
+        crc = kernels->bench_state(blksize, block, res->seed1, res->seed2, 0x22, crc);
+        now = core_ticks_stop();
+        w->quanta++;
+        if (now - prev > w->baseline + threshold)
+        {
+            uint64_t noise = now - prev - w->baseline;
+            w->events++;
+            w->stolen += noise;
+            if (noise > w->max)
+                w->max = noise;
+            if (w->log.size() < NOISE_MAX_EVENTS)
+                w->log.push_back({prev - origin, noise, w->cpu});
+        }
+        prev = now;
+    } while (now - start < duration);
+    w->elapsed = now - start;
+    res->crc = crc;
+}
+
+void core_noise_run(core_results *results, uint32_t count, double secs, double threshold_us)
+{
+    double tps = core_ticks_per_sec(), us = 1e6 / tps;
+    std::vector<noise_worker> workers(count);
+    std::vector<std::thread> threads;
+    std::vector<noise_event> all;
+    uint64_t events = 0, stolen = 0, elapsed = 0, origin = core_ticks_start();
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        workers[i].res = &results[i];
+        threads.emplace_back(noise_worker_run, &workers[i], origin, (uint64_t)(secs * tps), (uint64_t)(threshold_us * tps / 1e6));
+    }
+    for (i = 0; i < count; i++)
+        threads[i].join();
+
+    printf("Noise threshold  : %.3f us above the baseline quantum\n", threshold_us);
+    for (i = 0; i < count; i++)
+    {
+        noise_worker *w = &workers[i];
+        double run = (double)w->elapsed / tps;
+        printf("[%u]noise cpu %-4d: %s, baseline %.3f us, %llu quanta, %llu events, %.3f events/sec, stolen %.3f us (%.4f%%), max %.3f us\n", i,
+               w->cpu, w->pinned ? "pinned" : "unpinned", us * w->baseline, (unsigned long long)w->quanta, (unsigned long long)w->events,
+               w->events / run, us * w->stolen, 100.0 * w->stolen / w->elapsed, us * w->max);
+        events += w->events;
+        stolen += w->stolen;
+        elapsed += w->elapsed;
+        all.insert(all.end(), w->log.begin(), w->log.end());
+    }
+    printf("Noise events     : %llu, %.3f events/sec per CPU\n", (unsigned long long)events, events / ((double)elapsed / tps));
+    printf("Noise stolen     : %.3f us, %.4f%% of the measured time\n", us * stolen, elapsed ? 100.0 * stolen / elapsed : 0.0);
+
+    std::sort(all.begin(), all.end(), [](const noise_event &a, const noise_event &b) { return a.noise > b.noise; });
+    if (all.size() > NOISE_REPORT_EVENTS)
+        all.resize(NOISE_REPORT_EVENTS);
+    for (const noise_event &e : all)
+        printf("Noise event      : at %.6f secs, cpu %d, %.3f us\n", (double)e.start / tps, e.cpu, us * e.noise);
+}
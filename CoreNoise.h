@@ -0,0 +1,22 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Runs one core_bench_state pass per quantum on every pinned context for secs seconds and reports
+   every quantum that took more than threshold_us longer than the calibrated baseline as OS noise. */
+void core_noise_run(core_results *results, uint32_t count, double secs, double threshold_us);
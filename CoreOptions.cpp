@@ -0,0 +1,274 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreOptions.h"
+
+#include "CoreListJoin.h" // for CORE_MAX_INTERLEAVE
+#include "CoreUtil.h"     // for parseval
+
+#include <cstdio>  // for printf
+#include <cstdlib> // for strtod
+#include <cstring> // for strcmp, strncmp, strlen
+#include <vector>  // for vector
+
+/* Returns true if arg is --name or --name=value, value points past '=' or is nullptr. */
+static bool match_option(char *arg, const char *name, char **value)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg + 2, name, len) != 0)
+        return false;
+    if (arg[2 + len] == '\0')
+    {
+        *value = nullptr;
+        return true;
+    }
+    if (arg[2 + len] == '=')
+    {
+        *value = arg + 3 + len;
+        return true;
+    }
+    return false;
+}
+
+/* Parses a list of values separated by ',' or ':' */
+template <typename T> static void parse_list(char *value, std::vector<T> *list)
+{
+    while (*value)
+    {
+        list->push_back((T)parseval(value));
+        while (*value && (*value != ',') && (*value != ':'))
+            value++;
+        if (*value)
+            value++;
+    }
+}
+
+bool parse_options(int *argc, char *argv[], core_options *opts)
+{
+    int i, kept = 1;
+    char *value;
+
+    for (i = 1; i < *argc; i++)
+    {
+        char *arg = argv[i];
+        if ((arg[0] != '-') || (arg[1] != '-'))
+        {
+            argv[kept++] = arg;
+            continue;
+        }
+        if (match_option(arg, "help", &value))
+        {
+            print_usage(argv[0]);
+            return false;
+        }
+        else if (match_option(arg, "threads", &value) && value)
+            opts->threads = (uint32_t)parseval(value);
+        else if (match_option(arg, "processes", &value) && !value)
+            opts->processes = true;
+        else if (match_option(arg, "interleave", &value) && value)
+            opts->interleave = (uint32_t)parseval(value);
+        else if (match_option(arg, "profile", &value))
+            opts->profile = value ? (uint32_t)parseval(value) : 1;
+        else if (match_option(arg, "histogram", &value))
+            opts->histogram = value ? (uint32_t)parseval(value) : 1;
+        else if (match_option(arg, "pin", &value) && !value)
+            opts->pin = true;
+        else if (match_option(arg, "noise", &value) && value)
+            opts->noise = strtod(value, nullptr);
+        else if (match_option(arg, "noise-threshold", &value) && value)
+            opts->noise_threshold = strtod(value, nullptr);
+        else if (match_option(arg, "sched", &value) && value && !strcmp(value, "fifo"))
+            opts->sched = SCHED_POLICY_FIFO;
+        else if (match_option(arg, "sched", &value) && value && !strcmp(value, "rr"))
+            opts->sched = SCHED_POLICY_RR;
+        else if (match_option(arg, "priority", &value) && value)
+            opts->priority = parseval(value);
+        else if (match_option(arg, "nice", &value) && value)
+        {
+            opts->nice = parseval(value);
+            if (opts->sched == SCHED_POLICY_NONE)
+                opts->sched = SCHED_POLICY_NICE;
+        }
+        else if (match_option(arg, "mlock", &value) && !value)
+            opts->mlock = true;
+        else if (match_option(arg, "prefault", &value) && !value)
+            opts->prefault = true;
+        else if (match_option(arg, "snapshot", &value) && !value)
+            opts->snapshot = true;
+        else if (match_option(arg, "skip-isolated", &value) && !value)
+            opts->skip_isolated = true;
+        else if (match_option(arg, "numa", &value) && value && !strcmp(value, "local"))
+            opts->numa = NUMA_POLICY_LOCAL;
+        else if (match_option(arg, "numa", &value) && value && !strcmp(value, "interleave"))
+            opts->numa = NUMA_POLICY_INTERLEAVE;
+        else if (match_option(arg, "numa", &value) && value && !strcmp(value, "remote"))
+            opts->numa = NUMA_POLICY_REMOTE;
+        else if (match_option(arg, "serial-init", &value) && !value)
+            opts->serial_init = true;
+        else if (match_option(arg, "duration", &value) && value)
+            opts->duration = strtod(value, nullptr);
+        else if (match_option(arg, "history", &value) && value)
+            opts->history = value;
+        else if (match_option(arg, "compare", &value) && !value)
+            opts->compare = true;
+        else if (match_option(arg, "significance", &value) && value)
+            opts->significance = strtod(value, nullptr);
+        else if (match_option(arg, "metrics", &value) && value)
+            opts->metrics = value;
+        else if (match_option(arg, "period", &value) && value)
+            opts->period = strtod(value, nullptr);
+        else if (match_option(arg, "runs", &value) && value)
+            opts->runs = (uint32_t)parseval(value);
+        else if (match_option(arg, "duty", &value) && value)
+            opts->duty = strtod(value, nullptr);
+        else if (match_option(arg, "rate", &value) && value)
+            opts->rate = strtod(value, nullptr);
+        else if (match_option(arg, "slice", &value) && value)
+            opts->slice = strtod(value, nullptr);
+        else if (match_option(arg, "thread-execs", &value) && value)
+            parse_list(value, &opts->thread_execs);
+        else if (match_option(arg, "thread-seeds", &value) && value)
+            parse_list(value, &opts->thread_seeds);
+        else if (match_option(arg, "reference", &value) && !value)
+            opts->reference = true;
+        else if (match_option(arg, "reference-cache", &value) && value)
+        {
+            opts->reference = true;
+            opts->reference_cache = value;
+        }
+        else if (match_option(arg, "energy", &value))
+            opts->energy = value ? value : "/sys/class/powercap";
+        else if (match_option(arg, "frequency", &value))
+            opts->frequency = value ? (uint32_t)parseval(value) : 100;
+        else if (match_option(arg, "isa", &value) && value)
+            opts->isa = value;
+        else if (match_option(arg, "isa-scores", &value))
+            opts->isa_scores = value ? strtod(value, nullptr) : 2;
+        else if (match_option(arg, "usage", &value))
+            opts->usage = value ? (uint32_t)parseval(value) : 100;
+        else if (match_option(arg, "list-layout", &value) && value && !strcmp(value, "sequential"))
+            opts->list_layout = LIST_LAYOUT_SEQUENTIAL;
+        else if (match_option(arg, "list-layout", &value) && value && !strncmp(value, "strided", 7) && ((value[7] == '\0') || (value[7] == ':')))
+        {
+            opts->list_layout = LIST_LAYOUT_STRIDED;
+            if (value[7] == ':')
+                opts->list_stride = (uint32_t)parseval(value + 8);
+        }
+        else if (match_option(arg, "list-layout", &value) && value && !strcmp(value, "shuffled"))
+            opts->list_layout = LIST_LAYOUT_SHUFFLED;
+        else if (match_option(arg, "trace", &value) && value)
+            opts->trace = value;
+        else if (match_option(arg, "replay", &value) && value)
+            opts->replay = value;
+        else if (match_option(arg, "interference", &value))
+            opts->interference = value ? strtod(value, nullptr) : 0.5;
+        else if (match_option(arg, "matrix-types", &value))
+            opts->matrix_types = value ? strtod(value, nullptr) : 2;
+        else
+        {
+            printf("ERROR! Unknown option %s\n", arg);
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    if ((opts->duty > 100) || ((opts->duty > 0) && (opts->rate > 0)) || (opts->slice <= 0))
+    {
+        printf("ERROR! --duty must be at most 100, cannot be combined with --rate, and --slice must be positive\n");
+        return false;
+    }
+    if (opts->thread_seeds.size() % 3)
+    {
+        printf("ERROR! --thread-seeds needs three seeds per context\n");
+        return false;
+    }
+    if ((opts->interleave < 1) || (opts->interleave > CORE_MAX_INTERLEAVE) || ((opts->interleave > 1) && opts->processes))
+    {
+        printf("ERROR! --interleave must be between 1 and %d and cannot be combined with --processes\n", CORE_MAX_INTERLEAVE);
+        return false;
+    }
+    /* these modes pin a context per CPU, the interleaved contexts of a CPU would measure each other instead of the system */
+    if ((opts->interleave > 1) && ((opts->noise > 0) || (opts->duty > 0) || (opts->rate > 0) || (opts->interference > 0)))
+    {
+        printf("ERROR! --interleave cannot be combined with --noise, --duty, --rate or --interference\n");
+        return false;
+    }
+    if (opts->compare && !opts->history)
+    {
+        printf("ERROR! --compare needs --history\n");
+        return false;
+    }
+    argv[kept] = nullptr;
+    *argc = kept;
+    return true;
+}
+
+void print_usage(const char *program)
+{
+    printf("Usage: %s [options] [seed1 seed2 seed3 iterations execs unused size]\n", program);
+    printf("Options:\n");
+    printf("  --threads=N       number of parallel contexts, default is the number of allowed CPUs within the cgroup limits\n");
+    printf("  --processes       run each context in a forked process instead of a thread\n");
+    printf("  --interleave=K    every thread runs K contexts and interleaves their list finds and reversals\n");
+    printf("  --profile[=N]     report the time spent in each workload per thread, sampling every Nth iteration\n");
+    printf("  --histogram[=N]   report latency percentiles of every Nth iteration per thread\n");
+    printf("  --pin             pin every context to its own CPU\n");
+    printf("  --noise=SECS      measure OS noise on every pinned context with core_bench_state quanta instead of the benchmark\n");
+    printf("  --noise-threshold=US\n");
+    printf("                    quanta longer than the baseline by more than US microseconds are noise events, default 5\n");
+    printf("  --sched=fifo|rr   run the measured workers with a real-time scheduling policy\n");
+    printf("  --priority=N      real-time priority for --sched, default 1\n");
+    printf("  --nice=N          run the measured workers with a nice value\n");
+    printf("  --mlock           lock all memory with mlockall before the measured phase\n");
+    printf("  --prefault        touch every page of the memory blocks before the measured phase\n");
+    printf("  --snapshot        restore every context from a copy of its initialized data before every probe, score and run\n");
+    printf("  --skip-isolated   pin contexts only to CPUs not listed in isolcpus or nohz_full\n");
+    printf("  --numa=local|interleave|remote\n");
+    printf("                    allocate and initialize every context on its pinned CPU and place its pages on the local node,\n");
+    printf("                    all nodes or the next node\n");
+    printf("  --serial-init     initialize all contexts in the main thread instead of one thread per context\n");
+    printf("  --duration=SECS   target run time when the iterations are 0, default 11\n");
+    printf("  --history=FILE    append the score and the host fingerprint to FILE\n");
+    printf("  --compare         test the score against the history runs with the same fingerprint, exit with 2 on a regression\n");
+    printf("  --significance=P  significance level of the regression test, default 0.01\n");
+    printf("  --metrics=FILE    write the result in the OpenMetrics text format for the node_exporter textfile collector\n");
+    printf("  --period=SECS     repeat the measured phase every SECS seconds\n");
+    printf("  --runs=N          stop after N periodic runs, default is to run until killed\n");
+    printf("  --duty=PCT        generate load at PCT percent utilization per context for --duration seconds instead of the benchmark\n");
+    printf("  --rate=N          generate load at N iterations per second per context for --duration seconds instead of the benchmark\n");
+    printf("  --slice=MS        length of the work and sleep slices of --duty and --rate, default 10\n");
+    printf("  --thread-execs=M0,M1,...\n");
+    printf("                    execs mask of every context, cycled over the contexts\n");
+    printf("  --thread-seeds=S1:S2:S3,...\n");
+    printf("                    seeds of every context, cycled over the contexts\n");
+    printf("  --interference[=SECS]\n");
+    printf("                    measure the slowdown of every workload next to every other on sibling and non-sibling CPUs,\n");
+    printf("                    SECS per measurement, default 0.5\n");
+    printf("  --matrix-types[=SECS]\n");
+    printf("                    run the matrix workload over int8, int16, int32, float and double for SECS each, default 2,\n");
+    printf("                    and validate every type against the reference build\n");
+    printf("  --reference       validate every context against CRCs computed by an unoptimized build of the kernels\n");
+    printf("  --reference-cache=FILE\n");
+    printf("                    like --reference, and cache the reference CRCs in FILE\n");
+    printf("  --energy[=DIR]    report the RAPL energy of the measured phase, DIR is the powercap root, default /sys/class/powercap\n");
+    printf("  --frequency[=MS]  report the MHz of every worker CPU and CoreMark/MHz, from APERF/MPERF or scaling_cur_freq sampled every MS, default 100\n");
+    printf("  --isa=LEVEL       run the kernels built for baseline, x86-64-v2, v3 or v4 instead of the best level the CPU supports\n");
+    printf("  --isa-scores[=SECS]\n");
+    printf("                    score every available ISA level for SECS seconds before the run, default 2\n");
+    printf("  --usage[=N]       report context switches, migrations and page faults of every thread and the peak RSS,\n");
+    printf("                    flag threads with more than N involuntary context switches, default 100\n");
+    printf("  --list-layout=L   place the list nodes sequential (default), strided[:N] N nodes apart (default 4) or shuffled\n");
+    printf("  --trace=FILE      record the calc_func dispatches of the iterations of one context to FILE\n");
+    printf("  --replay=FILE     run the workload kernels of a trace without the list, the iterations argument is the number of passes\n");
+    printf("  --help            print this message\n");
+}
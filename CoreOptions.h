@@ -0,0 +1,70 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListLayout.h"
+#include "CoreSystem.h"
+#include <cstdint>
+#include <vector>
+
+struct core_options
+{
+    uint32_t threads = 0;                        /* Number of parallel contexts, 0 to detect */
+    bool processes = false;                      /* Run each context in a forked process */
+    uint32_t interleave = 1;                     /* Contexts every thread runs with their list traversals interleaved */
+    uint32_t profile = 0;                        /* Attribute the time of every Nth iteration to the workloads, 0 disables */
+    uint32_t histogram = 0;                      /* Record the duration of every Nth iteration, 0 disables */
+    bool pin = false;                            /* Pin context i to the i-th allowed CPU */
+    double noise = 0;                            /* Run the OS noise detection for this many seconds instead of the benchmark */
+    double noise_threshold = 5;                  /* Noise events are quanta longer than the baseline by this many microseconds */
+    core_sched_policy sched = SCHED_POLICY_NONE; /* Scheduling policy of the measured workers */
+    int32_t priority = 1;                        /* Real-time priority for SCHED_POLICY_FIFO and SCHED_POLICY_RR */
+    int32_t nice = 0;                            /* Nice value for SCHED_POLICY_NICE */
+    bool mlock = false;                          /* Lock the memory of the process before the measured phase */
+    bool prefault = false;                       /* Touch every page of the memory blocks before the measured phase */
+    bool snapshot = false;                       /* Restore every context from a copy of its initialized data before every sample */
+    bool skip_isolated = false;                  /* Do not pin contexts to isolcpus and nohz_full CPUs */
+    core_numa_policy numa = NUMA_POLICY_NONE;    /* Initialize every context on its pinned CPU with this placement */
+    bool serial_init = false;                    /* Initialize all contexts in the main thread */
+    double duration = 11;                        /* Target run time in seconds when the iterations are 0 */
+    const char *history = nullptr;               /* File the result of every run is appended to */
+    bool compare = false;                        /* Test the score against the history before appending it */
+    double significance = 0.01;                  /* Significance level of the regression test */
+    const char *metrics = nullptr;               /* OpenMetrics file written after every run */
+    double period = 0;                           /* Start a new run every this many seconds, 0 runs once */
+    uint32_t runs = 0;                           /* Number of periodic runs, 0 runs until killed */
+    double duty = 0;                             /* Generate load at this utilization in percent instead of the benchmark */
+    double rate = 0;                             /* Generate load at this many iterations per second per context */
+    double slice = 10;                           /* Length of a work and sleep slice in milliseconds */
+    std::vector<uint32_t> thread_execs;          /* execs of context i is element i modulo the size */
+    std::vector<int32_t> thread_seeds;           /* seed1, seed2 and seed3 of every context, cycled like thread_execs */
+    bool reference = false;                      /* Validate every context against CRCs from the reference build of the kernels */
+    const char *reference_cache = nullptr;       /* File caching the reference CRCs */
+    const char *energy = nullptr;                /* powercap root to sample the RAPL energy counters from */
+    uint32_t frequency = 0;                      /* Measure the CPU frequency, sampling scaling_cur_freq every this many ms, 0 disables */
+    const char *isa = nullptr;                   /* Force the kernels of this ISA level instead of the best one CPUID allows */
+    double isa_scores = 0;                       /* Score every available ISA level for this many seconds before the run */
+    uint32_t usage = 0;                          /* Report the OS counters of every thread, flag more involuntary switches than this, 0 disables */
+    core_list_layout list_layout{};              /* Placement of the list nodes in their block, sequential by default */
+    uint32_t list_stride = 4;                    /* Distance in nodes of the strided layout */
+    const char *trace = nullptr;                 /* Record the calc_func dispatches of one context to this file */
+    const char *replay = nullptr;                /* Replay the workload kernels of this trace file */
+    double interference = 0;                     /* Measure the slowdown of every workload pair for this many seconds per run */
+    double matrix_types = 0;                     /* Run the matrix of every element type for this many seconds instead of the benchmark */
+};
+
+/* Consumes all --name[=value] arguments and leaves the positional seed arguments in argv. */
+bool parse_options(int *argc, char *argv[], core_options *opts);
+void print_usage(const char *program);
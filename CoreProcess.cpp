@@ -0,0 +1,196 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreProcess.h"
+
+#include "CoreIsa.h"    // for core_isa
+#include "CoreSystem.h" // for core_lock_memory, core_thread_usage, core_usage_delta
+
+#include <cstdio> // for printf
+
+#if defined(_WIN32)
+
+bool core_fork_processes(core_results *, uint32_t, bool)
+{
+    printf("Process mode is not supported on this platform, using threads.\n");
+    return false;
+}
+
+void core_start_processes(void)
+{
+}
+
+void core_stop_processes(core_results *, uint32_t)
+{
+}
+
+#else
+
+#include <atomic>     // for atomic
+#include <chrono>     // for steady_clock
+#include <new>        // for placement new
+#include <sys/mman.h> // for mmap, munmap
+#include <sys/wait.h> // for waitpid, WIFEXITED, WNOHANG
+#include <thread>     // for this_thread::yield
+#include <unistd.h>   // for fork, _exit
+#include <vector>     // for vector
+
+struct core_process_slot
+{
+    uint16_t crc;
+    uint16_t crcs[NUM_WORKLOADS];
+    uint32_t iterations;
+    int32_t cpu;
+    bool sched_ok;
+    CORE_TICKS time; /* Time spent in iterate() by the child */
+    core_profile profile;
+    core_histogram histogram;
+    core_usage usage;
+    bool usage_ok;
+};
+
+struct core_process_shared
+{
+    std::atomic<uint32_t> ready; /* Number of children that finished initialization */
+    std::atomic<uint32_t> go;    /* Set by the parent to start the measured phase */
+};
+
+static core_process_shared *shared = nullptr;
+static core_process_slot *slots = nullptr;
+static size_t shared_size = 0;
+static std::vector<pid_t> pids;
+static bool lock_memory = false;
+
+static void core_process_main(core_results *res, core_process_slot *slot)
+{
+    core_setup_thread(res);
+    slot->cpu = res->cpu;
+    slot->sched_ok = res->sched_ok;
+    /* memory locks are not inherited through fork */
+    if (lock_memory)
+        core_lock_memory();
+    /* re-initialize in place, so every page is private to this process before the timed phase */
+    core_init_context(res);
+    shared->ready.fetch_add(1);
+    while (shared->go.load() == 0)
+        std::this_thread::yield();
+
+    core_usage before, after;
+    slot->usage_ok = core_thread_usage(&before);
+    auto start = std::chrono::steady_clock::now();
+    core_isa()->iterate(res);
+    slot->time = std::chrono::steady_clock::now() - start;
+    slot->usage_ok = slot->usage_ok && core_thread_usage(&after);
+    slot->usage = core_usage_delta(before, after);
+    slot->crc = res->crc;
+    for (uint32_t w = 0; w < NUM_WORKLOADS; w++)
+        slot->crcs[w] = res->crcs[w];
+    slot->iterations = res->iterations;
+    slot->profile = res->profile;
+    slot->histogram = res->histogram;
+}
+
+bool core_fork_processes(core_results *results, uint32_t count, bool lock)
+{
+    uint32_t i;
+
+    lock_memory = lock;
+    shared_size = sizeof(core_process_shared) + count * sizeof(core_process_slot);
+    void *mem = mmap(nullptr, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        printf("ERROR! Cannot map shared memory for process mode, using threads.\n");
+        return false;
+    }
+    shared = new (mem) core_process_shared{};
+    slots = (core_process_slot *)(shared + 1);
+
+    fflush(stdout);
+    pids.assign(count, 0);
+    for (i = 0; i < count; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            core_process_main(&results[i], &slots[i]);
+            _exit(0);
+        }
+        if (pid < 0)
+        {
+            printf("ERROR! fork failed for context %u\n", i);
+            results[i].err++;
+            shared->ready.fetch_add(1);
+        }
+        pids[i] = pid;
+    }
+
+    /* a child only exits after the measured phase, so one that exits now died during its initialization */
+    uint32_t dead = 0;
+    while (shared->ready.load() + dead < count)
+    {
+        for (i = 0; i < count; i++)
+        {
+            int status;
+            if ((pids[i] > 0) && (waitpid(pids[i], &status, WNOHANG) == pids[i]))
+            {
+                printf("[%u]ERROR! child process %d exited before it was initialized\n", i, (int)pids[i]);
+                results[i].err++;
+                pids[i] = 0;
+                dead++;
+            }
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void core_start_processes(void)
+{
+    shared->go.store(1);
+}
+
+void core_stop_processes(core_results *results, uint32_t count)
+{
+    uint32_t i;
+    int status;
+
+    for (i = 0; i < count; i++)
+    {
+        if (pids[i] <= 0)
+            continue;
+        if ((waitpid(pids[i], &status, 0) != pids[i]) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            printf("[%u]ERROR! child process %d did not finish cleanly\n", i, (int)pids[i]);
+            results[i].err++;
+            continue;
+        }
+        results[i].crc = slots[i].crc;
+        for (uint32_t w = 0; w < NUM_WORKLOADS; w++)
+            results[i].crcs[w] = slots[i].crcs[w];
+        results[i].iterations = slots[i].iterations;
+        results[i].cpu = slots[i].cpu;
+        results[i].sched_ok = slots[i].sched_ok;
+        results[i].time = slots[i].time;
+        results[i].profile = slots[i].profile;
+        results[i].histogram = slots[i].histogram;
+        results[i].usage = slots[i].usage;
+        results[i].usage_ok = slots[i].usage_ok;
+    }
+
+    munmap(shared, shared_size);
+    shared = nullptr;
+    slots = nullptr;
+}
+
+#endif
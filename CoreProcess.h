@@ -0,0 +1,26 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include <cstdint>
+
+/* Forks one process per context and waits until every child has initialized its own copy,
+   lock asks the children to lock their memory like the parent did. */
+bool core_fork_processes(core_results *results, uint32_t count, bool lock);
+/* Releases the children into the measured phase. */
+void core_start_processes(void);
+/* Waits for the children and copies their outputs back into results. */
+void core_stop_processes(core_results *results, uint32_t count);
@@ -0,0 +1,112 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreProfile.h"
+
+#include "CoreListJoin.h" // for core_results
+
+#include <algorithm> // for max
+#include <cstdio>    // for printf
+
+static uint64_t overhead_ticks = 0;
+static double ticks_per_sec = 1e9;
+
+void core_profile_calibrate(void)
+{
+    uint64_t best = UINT64_MAX, start, stop;
+    int i;
+
+    /* the smallest back-to-back delta is what every measured interval carries on top of the real work */
+    for (i = 0; i < 10000; i++)
+    {
+        start = core_ticks_start();
+        stop = core_ticks_stop();
+        if (stop - start < best)
+            best = stop - start;
+    }
+    overhead_ticks = best;
+
+    auto clock_start = std::chrono::steady_clock::now();
+    start = core_ticks_start();
+    while (std::chrono::steady_clock::now() - clock_start < std::chrono::milliseconds(20))
+        ;
+    stop = core_ticks_stop();
+    auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - clock_start).count();
+    ticks_per_sec = (double)(stop - start) / secs;
+}
+
+double core_ticks_per_sec(void)
+{
+    return ticks_per_sec;
+}
+
+/* Converts the inclusive ticks of res into self time of each slot, the dispatch workloads and their CRC
+   folding run inside the list workload, so they are subtracted from it together with the timer
+   overhead of every nested measurement. The list time of a leader covers the interleaved traversals of
+   its whole group, so the nested calls of every member with a list are subtracted from it. */
+static void core_profile_self(const core_results *res, double *secs)
+{
+    const core_profile *p = &res->profile;
+    uint32_t i, c, members = std::max(res->group, 1u);
+    double scale = p->sampled ? (double)res->iterations / p->sampled : 0;
+    double list = (double)p->ticks[WORKLOAD_LIST] - (double)(p->calls[WORKLOAD_LIST] * overhead_ticks);
+
+    for (i = 0; i < NUM_PROFILE_SLOTS; i++)
+    {
+        double self = (double)p->ticks[i] - (double)(p->calls[i] * overhead_ticks);
+        bool nested = (i == PROFILE_CRC) || (workloads[i].dispatch == DISPATCH_CALC);
+        for (c = 0; nested && p->calls[WORKLOAD_LIST] && (c < members); c++)
+        {
+            const core_profile *m = &res[c].profile;
+            if (res[c].execs & workload_mask(WORKLOAD_LIST))
+                list -= (double)m->ticks[i] + (double)(m->calls[i] * overhead_ticks);
+        }
+        secs[i] = (self > 0) ? scale * self / ticks_per_sec : 0;
+    }
+    secs[WORKLOAD_LIST] = (list > 0) ? scale * list / ticks_per_sec : 0;
+}
+
+static void core_profile_print(const char *prefix, const double *secs)
+{
+    uint32_t i;
+    double total = 0;
+
+    for (i = 0; i < NUM_PROFILE_SLOTS; i++)
+        total += secs[i];
+    for (i = 0; i < NUM_PROFILE_SLOTS; i++)
+    {
+        const char *name = (i == PROFILE_CRC) ? "crc" : workloads[i].name;
+        printf("%sprofile %-7s: %f secs %6.2f%%\n", prefix, name, secs[i], (total > 0) ? 100.0 * secs[i] / total : 0.0);
+    }
+}
+
+void core_profile_report(core_results *results, uint32_t count)
+{
+    uint32_t i, j;
+    double secs[NUM_PROFILE_SLOTS], all[NUM_PROFILE_SLOTS] = {};
+    char prefix[16];
+
+    printf("Profile timer    : %s, %.3f ticks/ns, overhead %llu ticks subtracted per call\n", CORE_HAS_TSC ? "rdtsc" : "steady_clock",
+           ticks_per_sec / 1e9, (unsigned long long)overhead_ticks);
+    printf("Profile sampling : every %u iteration(s), scaled to all iterations\n", results[0].profile.every);
+    for (i = 0; i < count; i++)
+    {
+        core_profile_self(&results[i], secs);
+        snprintf(prefix, sizeof(prefix), "[%u]", i);
+        core_profile_print(prefix, secs);
+        for (j = 0; j < NUM_PROFILE_SLOTS; j++)
+            all[j] += secs[j];
+    }
+    core_profile_print("[all]", all);
+}
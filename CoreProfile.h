@@ -0,0 +1,90 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreWorkload.h"
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CORE_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CORE_HAS_TSC 1
+#else
+#define CORE_HAS_TSC 0
+#endif
+
+struct core_results;
+
+/* Profile slots are the workloads followed by the CRC folding done by the dispatchers */
+#define PROFILE_CRC NUM_WORKLOADS
+#define NUM_PROFILE_SLOTS (NUM_WORKLOADS + 1)
+
+struct core_profile
+{
+    uint32_t every;                    /* Profile every Nth iteration, 0 disables profiling */
+    bool active;                       /* The current iteration is profiled */
+    uint32_t sampled;                  /* Number of profiled iterations */
+    uint64_t ticks[NUM_PROFILE_SLOTS]; /* Inclusive ticks, nested calls are counted by their parent as well */
+    uint64_t calls[NUM_PROFILE_SLOTS];
+};
+
+/* rdtsc at the start of an interval */
+inline uint64_t core_ticks_start(void)
+{
+#if CORE_HAS_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/* rdtscp at the end of an interval, waits for the measured code to retire */
+inline uint64_t core_ticks_stop(void)
+{
+#if CORE_HAS_TSC
+    unsigned int aux;
+    return __rdtscp(&aux);
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+inline void core_profile_iteration(core_profile *p, uint32_t iteration)
+{
+    if (p->every)
+    {
+        p->active = (iteration % p->every) == 0;
+        p->sampled += p->active;
+    }
+}
+
+template <typename F> inline auto core_profile_call(core_profile *p, uint32_t slot, F &&f)
+{
+    if (!p->active)
+        return f();
+    uint64_t start = core_ticks_start();
+    auto ret = f();
+    p->ticks[slot] += core_ticks_stop() - start;
+    p->calls[slot]++;
+    return ret;
+}
+
+/* Measures the timer overhead and the tick rate, call once before the profiled run */
+void core_profile_calibrate(void);
+double core_ticks_per_sec(void);
+void core_profile_report(core_results *results, uint32_t count);
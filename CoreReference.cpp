@@ -0,0 +1,91 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/* Compiled only into the reference build, where CORE_KERNEL puts the kernels into their own namespace */
+#include "CoreReference.h"
+
+#include <cstdio>  // for fopen, fgets, fprintf, sscanf
+#include <cstdlib> // for free, malloc
+
+CORE_KERNEL_BEGIN
+
+static void reference_run(const core_results *proto, uint16_t crcs[NUM_WORKLOADS])
+{
+    core_results res{};
+    uint32_t w;
+
+    res.seed1 = proto->seed1;
+    res.seed2 = proto->seed2;
+    res.seed3 = proto->seed3;
+    res.execs = proto->execs;
+    res.size = proto->size;
+    res.iterations = 1;
+    res.memblock[0] = malloc(res.size * workload_shares(res.execs));
+    core_init_context(&res);
+    iterate(&res);
+    for (w = 0; w < NUM_WORKLOADS; w++)
+        crcs[w] = res.crcs[w];
+    free(res.memblock[0]);
+}
+
+CORE_KERNEL_END
+
+/* The cache has one line per context configuration: seed1 seed2 seed3 size execs, then the CRCs */
+bool core_reference_crcs(const core_results *res, const char *cache, uint16_t crcs[NUM_WORKLOADS])
+{
+    char line[256];
+    uint32_t w;
+    FILE *f;
+
+    if (cache && ((f = fopen(cache, "r")) != nullptr))
+    {
+        while (fgets(line, sizeof(line), f))
+        {
+            unsigned seed1, seed2, seed3, size, execs, crc;
+            int offset, used;
+            if ((sscanf(line, "%x %x %x %u %x%n", &seed1, &seed2, &seed3, &size, &execs, &offset) != 5) || (seed1 != (uint16_t)res->seed1) ||
+                (seed2 != (uint16_t)res->seed2) || (seed3 != (uint16_t)res->seed3) || (size != res->size) || (execs != res->execs))
+                continue;
+            for (w = 0; (w < NUM_WORKLOADS) && (sscanf(line + offset, "%x%n", &crc, &used) == 1); w++, offset += used)
+                crcs[w] = (uint16_t)crc;
+            if (w == NUM_WORKLOADS)
+            {
+                fclose(f);
+                return true;
+            }
+        }
+        fclose(f);
+    }
+
+    CORE_KERNEL::reference_run(res, crcs);
+    if (cache && ((f = fopen(cache, "a")) != nullptr))
+    {
+        fprintf(f, "0x%04x 0x%04x 0x%04x %u 0x%x", (uint16_t)res->seed1, (uint16_t)res->seed2, (uint16_t)res->seed3, res->size, res->execs);
+        for (w = 0; w < NUM_WORKLOADS; w++)
+            fprintf(f, " 0x%04x", crcs[w]);
+        fprintf(f, "\n");
+        fclose(f);
+    }
+    return false;
+}
+
+uint16_t core_reference_matrix_crc(core_matrix_type type, uint32_t blksize, int32_t seed, uint32_t iterations)
+{
+    void *memblk = malloc(blksize);
+    uint16_t first;
+    uint32_t N;
+    uint16_t crc = CORE_KERNEL::core_matrix_type_run(type, blksize, memblk, seed, iterations, &first, &N);
+    free(memblk);
+    return crc;
+}
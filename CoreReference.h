@@ -0,0 +1,27 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreListJoin.h"
+#include "CoreMatrix.h"
+#include <cstdint>
+
+/* Expected CRC of the first iteration of every workload in the execs of the context, computed by the
+   unoptimized reference build of the kernels, or read from the cache file if it is not nullptr.
+   Returns true if the value came from the cache. */
+bool core_reference_crcs(const core_results *res, const char *cache, uint16_t crcs[NUM_WORKLOADS]);
+
+/* CRC of iterations passes of the matrix of the type, computed by the reference build of the kernels */
+uint16_t core_reference_matrix_crc(core_matrix_type type, uint32_t blksize, int32_t seed, uint32_t iterations);
@@ -18,8 +18,11 @@ Original Author: Shay Gal-on
 
 #include "CoreState.h"
 
+#include "CoreListJoin.h" // for core_results
 #include "CoreUtil.h"
 
+CORE_KERNEL_BEGIN
+
 uint16_t core_bench_state(uint32_t blksize, uint8_t *memblock, int16_t seed1, int16_t seed2, int16_t step, uint16_t crc)
 {
     uint32_t final_counts[NUM_CORE_STATES];
@@ -88,6 +91,18 @@ uint16_t core_bench_state(uint32_t blksize, uint8_t *memblock, int16_t seed1, in
     return crc;
 }
 
+void workload_state_init(core_results *res, uint32_t blksize, void *memblk)
+{
+    core_init_state(blksize, res->seed1, (uint8_t *)memblk);
+}
+
+uint16_t workload_state_bench(core_results *res, int16_t arg)
+{
+    if (arg < 0x22)
+        arg = 0x22;
+    return core_bench_state(res->size * workloads[WORKLOAD_STATE].share, (uint8_t *)res->memblock[1 + WORKLOAD_STATE], res->seed1, res->seed2, arg, res->crc);
+}
+
 /* Default initialization patterns */
 static uint8_t *intpat[4] = {(uint8_t *)"5012", (uint8_t *)"1234", (uint8_t *)"-874", (uint8_t *)"+122"};
 static uint8_t *floatpat[4] = {(uint8_t *)"35.54400", (uint8_t *)".1234500", (uint8_t *)"-110.700", (uint8_t *)"+0.64400"};
@@ -275,3 +290,5 @@ CORE_STATE core_state_transition(uint8_t **instr, uint32_t *transition_count)
     *instr = str;
     return state;
 }
+
+CORE_KERNEL_END
@@ -18,6 +18,7 @@ Original Author: Shay Gal-on
 
 #pragma once
 
+#include "CoreKernel.h"
 #include <cstdint>
 
 enum CORE_STATE
@@ -33,8 +34,12 @@ enum CORE_STATE
     NUM_CORE_STATES,
 };
 
+CORE_KERNEL_BEGIN
+
 CORE_STATE core_state_transition(uint8_t **instr, uint32_t *transition_count);
 
 uint16_t core_bench_state(uint32_t blksize, uint8_t *memblock, int16_t seed1, int16_t seed2, int16_t step, uint16_t crc);
 
 void core_init_state(uint32_t size, int16_t seed, uint8_t *p);
+
+CORE_KERNEL_END
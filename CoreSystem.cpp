@@ -0,0 +1,499 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreSystem.h"
+
+#include <algorithm> // for upper_bound, max
+#include <cmath>     // for ceil
+#include <cstdio>    // for fopen, fgets, fscanf, snprintf, sscanf
+#include <cstdlib>   // for strtod, strtoul, malloc, free
+#include <cstring>   // for strcmp, strcspn, strncmp
+#include <string>    // for string
+#include <thread>    // for thread
+
+#define PREFAULT_PAGE_SIZE 4096
+
+/* Parses a kernel CPU or node list like "1-3,8" */
+static void core_parse_cpu_list(const char *text, std::vector<uint32_t> *cpus)
+{
+    while (*text)
+    {
+        char *end;
+        uint32_t first = (uint32_t)strtoul(text, &end, 10), last = first;
+        if (end == text)
+            break;
+        if (*end == '-')
+            last = (uint32_t)strtoul(end + 1, &end, 10);
+        for (; first <= last; first++)
+            cpus->push_back(first);
+        text = (*end == ',') ? end + 1 : end;
+    }
+}
+
+static void core_read_cpu_list(const char *path, std::vector<uint32_t> *cpus)
+{
+    char line[4096];
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+        return;
+    if (fgets(line, sizeof(line), f))
+        core_parse_cpu_list(line, cpus);
+    fclose(f);
+}
+
+std::vector<uint32_t> core_cpu_siblings(uint32_t cpu)
+{
+    std::vector<uint32_t> cpus;
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", cpu);
+    core_read_cpu_list(path, &cpus);
+    if (cpus.empty())
+        cpus.push_back(cpu);
+    return cpus;
+}
+
+std::vector<uint32_t> core_isolated_cpus(void)
+{
+    std::vector<uint32_t> cpus;
+    core_read_cpu_list("/sys/devices/system/cpu/isolated", &cpus);
+    core_read_cpu_list("/sys/devices/system/cpu/nohz_full", &cpus);
+    return cpus;
+}
+
+const char *core_sched_name(core_sched_policy policy)
+{
+    switch (policy)
+    {
+        case SCHED_POLICY_NICE:
+            return "SCHED_OTHER";
+        case SCHED_POLICY_FIFO:
+            return "SCHED_FIFO";
+        case SCHED_POLICY_RR:
+            return "SCHED_RR";
+        default:
+            return "default";
+    }
+}
+
+const char *core_numa_name(core_numa_policy policy)
+{
+    switch (policy)
+    {
+        case NUMA_POLICY_LOCAL:
+            return "local";
+        case NUMA_POLICY_INTERLEAVE:
+            return "interleave";
+        case NUMA_POLICY_REMOTE:
+            return "remote";
+        default:
+            return "default";
+    }
+}
+
+std::vector<uint32_t> core_memory_nodes(void)
+{
+    std::vector<uint32_t> nodes;
+    core_read_cpu_list("/sys/devices/system/node/has_memory", &nodes);
+    if (nodes.empty())
+        nodes.push_back(0);
+    return nodes;
+}
+
+size_t core_prefault(void *block, size_t size)
+{
+    volatile uint8_t *p = (volatile uint8_t *)block;
+    size_t offset, pages = 0;
+
+    for (offset = 0; offset < size; offset += PREFAULT_PAGE_SIZE, pages++)
+        p[offset] = p[offset];
+    if (size > 0)
+        p[size - 1] = p[size - 1];
+    return pages;
+}
+
+#if defined(__linux__)
+
+#include <linux/mempolicy.h> // for MPOL_PREFERRED, MPOL_INTERLEAVE
+#include <sched.h>           // for sched_getaffinity, sched_setaffinity, sched_getcpu, sched_setscheduler
+#include <sys/mman.h>        // for mlockall, mmap, munmap
+#include <sys/resource.h>    // for getrusage, setpriority
+#include <sys/syscall.h>     // for SYS_gettid, SYS_getcpu, SYS_mbind, SYS_move_pages
+#include <unistd.h>          // for access, syscall, sysconf
+
+#define NUMA_MAX_NODES 1024
+
+std::vector<uint32_t> core_allowed_cpus(void)
+{
+    std::vector<uint32_t> cpus;
+    cpu_set_t set;
+    uint32_t cpu;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+    }
+    if (cpus.empty())
+        cpus.push_back(0);
+    return cpus;
+}
+
+bool core_pin_thread(uint32_t cpu)
+{
+    cpu_set_t set;
+
+    if (cpu >= CPU_SETSIZE)
+        return false;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int32_t core_current_cpu(void)
+{
+    return sched_getcpu();
+}
+
+bool core_set_scheduler(core_sched_policy policy, int32_t priority)
+{
+    sched_param param = {};
+
+    switch (policy)
+    {
+        case SCHED_POLICY_NICE:
+            /* on Linux the nice value is a per-thread attribute */
+            return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), priority) == 0;
+        case SCHED_POLICY_FIFO:
+            param.sched_priority = priority;
+            return sched_setscheduler(0, SCHED_FIFO, &param) == 0;
+        case SCHED_POLICY_RR:
+            param.sched_priority = priority;
+            return sched_setscheduler(0, SCHED_RR, &param) == 0;
+        default:
+            return true;
+    }
+}
+
+bool core_lock_memory(void)
+{
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+}
+
+int32_t core_current_node(void)
+{
+    unsigned cpu, node;
+
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        return -1;
+    return (int32_t)node;
+}
+
+/* raw syscalls, so there is no dependency on libnuma */
+void *core_alloc_block(size_t size, core_numa_policy policy)
+{
+    unsigned long mask[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {};
+    const size_t bits = 8 * sizeof(unsigned long);
+    std::vector<uint32_t> nodes;
+    int32_t local;
+    int mode = MPOL_PREFERRED;
+    void *block;
+
+    if (policy == NUMA_POLICY_NONE)
+        return malloc(size);
+    block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED)
+        return nullptr;
+
+    nodes = core_memory_nodes();
+    local = core_current_node();
+    if (policy == NUMA_POLICY_INTERLEAVE)
+    {
+        mode = MPOL_INTERLEAVE;
+        for (uint32_t node : nodes)
+            if (node < NUMA_MAX_NODES)
+                mask[node / bits] |= 1ul << (node % bits);
+    }
+    else
+    {
+        uint32_t node = (local >= 0) ? (uint32_t)local : nodes[0];
+        if (policy == NUMA_POLICY_REMOTE)
+        {
+            auto next = std::upper_bound(nodes.begin(), nodes.end(), node);
+            node = (next != nodes.end()) ? *next : nodes[0];
+        }
+        if (node < NUMA_MAX_NODES)
+            mask[node / bits] |= 1ul << (node % bits);
+    }
+    /* no page is touched yet, so the policy decides where the first touch places them;
+       the kernel drops the last bit of maxnode */
+    syscall(SYS_mbind, block, size, mode, mask, NUMA_MAX_NODES + 1, 0);
+    return block;
+}
+
+void core_free_block(void *block, size_t size, core_numa_policy policy)
+{
+    if (policy == NUMA_POLICY_NONE)
+        free(block);
+    else if (block != nullptr)
+        munmap(block, size);
+}
+
+std::vector<uint32_t> core_block_nodes(void *block, size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), count = (size + page - 1) / page, i;
+    std::vector<void *> pages(count);
+    std::vector<int> status(count);
+    std::vector<uint32_t> nodes;
+
+    for (i = 0; i < count; i++)
+        pages[i] = (uint8_t *)block + i * page;
+    /* without target nodes move_pages only reports the node of every page */
+    if (syscall(SYS_move_pages, 0, count, pages.data(), nullptr, status.data(), 0) != 0)
+        return nodes;
+    for (int node : status)
+    {
+        if (node < 0)
+            continue;
+        if (nodes.size() <= (size_t)node)
+            nodes.resize(node + 1);
+        nodes[node]++;
+    }
+    return nodes;
+}
+
+/* cgroup v2 is mounted on /sys/fs/cgroup, or on /sys/fs/cgroup/unified in the hybrid layout */
+static bool core_cgroup_dir(std::string *dir)
+{
+    char line[4096];
+    std::string path;
+    FILE *f = fopen("/proc/self/cgroup", "r");
+
+    if (f == nullptr)
+        return false;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, "0::", 3) != 0)
+            continue;
+        line[strcspn(line, "\r\n")] = 0;
+        path = line + 3;
+    }
+    fclose(f);
+    if (path.empty())
+        return false;
+    for (const char *mount : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"})
+    {
+        if (access((std::string(mount) + "/cgroup.controllers").c_str(), R_OK) == 0)
+        {
+            *dir = mount + ((path == "/") ? std::string() : path);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool core_read_cgroup(core_cgroup *cg)
+{
+    std::string dir, leaf;
+    std::vector<uint32_t> cpus;
+    char line[256], name[64];
+    unsigned long long value;
+    FILE *f;
+
+    *cg = core_cgroup{};
+    if (!core_cgroup_dir(&dir))
+        return false;
+    leaf = dir;
+
+    /* a quota of any ancestor limits the cgroup as well */
+    for (;;)
+    {
+        char quota[32];
+        double period;
+        if ((f = fopen((dir + "/cpu.max").c_str(), "r")) != nullptr)
+        {
+            if ((fscanf(f, "%31s %lf", quota, &period) == 2) && (strcmp(quota, "max") != 0) && (period > 0))
+            {
+                double cpus_quota = strtod(quota, nullptr) / period;
+                if ((cg->quota == 0) || (cpus_quota < cg->quota))
+                    cg->quota = cpus_quota;
+            }
+            fclose(f);
+        }
+        size_t slash = dir.rfind('/');
+        if ((slash == std::string::npos) || (access((dir.substr(0, slash) + "/cgroup.controllers").c_str(), R_OK) != 0))
+            break;
+        dir.resize(slash);
+    }
+
+    core_read_cpu_list((leaf + "/cpuset.cpus.effective").c_str(), &cpus);
+    cg->cpuset = (uint32_t)cpus.size();
+
+    if ((f = fopen((leaf + "/cpu.stat").c_str(), "r")) != nullptr)
+    {
+        while (fgets(line, sizeof(line), f))
+        {
+            if (sscanf(line, "%63s %llu", name, &value) != 2)
+                continue;
+            if (strcmp(name, "nr_periods") == 0)
+                cg->nr_periods = value;
+            else if (strcmp(name, "nr_throttled") == 0)
+                cg->nr_throttled = value;
+            else if (strcmp(name, "throttled_usec") == 0)
+                cg->throttled_usec = value;
+        }
+        fclose(f);
+    }
+    return true;
+}
+
+bool core_thread_usage(core_usage *u)
+{
+    char line[256], name[64];
+    unsigned long long value;
+    rusage ru;
+    FILE *f;
+
+    *u = core_usage{};
+    if (getrusage(RUSAGE_THREAD, &ru) != 0)
+        return false;
+    u->voluntary = (uint64_t)ru.ru_nvcsw;
+    u->involuntary = (uint64_t)ru.ru_nivcsw;
+    u->minor_faults = (uint64_t)ru.ru_minflt;
+    u->major_faults = (uint64_t)ru.ru_majflt;
+    /* only with CONFIG_SCHED_DEBUG */
+    if ((f = fopen("/proc/thread-self/sched", "r")) != nullptr)
+    {
+        while (fgets(line, sizeof(line), f))
+        {
+            if ((sscanf(line, "%63s : %llu", name, &value) == 2) && (strcmp(name, "se.nr_migrations") == 0))
+            {
+                u->migrations = value;
+                u->migrations_ok = true;
+            }
+        }
+        fclose(f);
+    }
+    return true;
+}
+
+uint64_t core_peak_rss(bool children)
+{
+    rusage ru;
+
+    if (getrusage(children ? RUSAGE_CHILDREN : RUSAGE_SELF, &ru) != 0)
+        return 0;
+    return (uint64_t)ru.ru_maxrss;
+}
+
+#else
+
+std::vector<uint32_t> core_allowed_cpus(void)
+{
+    std::vector<uint32_t> cpus;
+    uint32_t cpu, count = std::thread::hardware_concurrency();
+
+    for (cpu = 0; cpu < count; cpu++)
+        cpus.push_back(cpu);
+    if (cpus.empty())
+        cpus.push_back(0);
+    return cpus;
+}
+
+bool core_pin_thread(uint32_t)
+{
+    return false;
+}
+
+int32_t core_current_cpu(void)
+{
+    return -1;
+}
+
+bool core_set_scheduler(core_sched_policy policy, int32_t)
+{
+    return policy == SCHED_POLICY_NONE;
+}
+
+bool core_lock_memory(void)
+{
+    return false;
+}
+
+int32_t core_current_node(void)
+{
+    return -1;
+}
+
+void *core_alloc_block(size_t size, core_numa_policy)
+{
+    return malloc(size);
+}
+
+void core_free_block(void *block, size_t, core_numa_policy)
+{
+    free(block);
+}
+
+std::vector<uint32_t> core_block_nodes(void *, size_t)
+{
+    return std::vector<uint32_t>();
+}
+
+bool core_read_cgroup(core_cgroup *cg)
+{
+    *cg = core_cgroup{};
+    return false;
+}
+
+bool core_thread_usage(core_usage *u)
+{
+    *u = core_usage{};
+    return false;
+}
+
+uint64_t core_peak_rss(bool)
+{
+    return 0;
+}
+
+#endif
+
+core_usage core_usage_delta(const core_usage &start, const core_usage &stop)
+{
+    core_usage d;
+
+    d.voluntary = stop.voluntary - start.voluntary;
+    d.involuntary = stop.involuntary - start.involuntary;
+    d.migrations = stop.migrations - start.migrations;
+    d.minor_faults = stop.minor_faults - start.minor_faults;
+    d.major_faults = stop.major_faults - start.major_faults;
+    d.migrations_ok = start.migrations_ok && stop.migrations_ok;
+    return d;
+}
+
+uint32_t core_default_threads(void)
+{
+    uint32_t count = (uint32_t)core_allowed_cpus().size();
+    core_cgroup cg;
+
+    if (core_read_cgroup(&cg))
+    {
+        if ((cg.cpuset > 0) && (cg.cpuset < count))
+            count = cg.cpuset;
+        if ((cg.quota > 0) && (std::ceil(cg.quota) < count))
+            count = (uint32_t)std::ceil(cg.quota);
+    }
+    return std::max(count, 1u);
+}
@@ -0,0 +1,97 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum core_sched_policy
+{
+    SCHED_POLICY_NONE, /* Leave the scheduling of the worker alone */
+    SCHED_POLICY_NICE, /* Default time-sharing policy with a nice value */
+    SCHED_POLICY_FIFO, /* SCHED_FIFO with a real-time priority */
+    SCHED_POLICY_RR,   /* SCHED_RR with a real-time priority */
+};
+
+enum core_numa_policy
+{
+    NUMA_POLICY_NONE,       /* Allocate with malloc in the main thread */
+    NUMA_POLICY_LOCAL,      /* Pages on the node of the CPU that initializes the block */
+    NUMA_POLICY_INTERLEAVE, /* Pages interleaved over all nodes with memory */
+    NUMA_POLICY_REMOTE,     /* Pages on the next node with memory after the local one */
+};
+
+/* CPUs the process may run on, in ascending order */
+std::vector<uint32_t> core_allowed_cpus(void);
+/* Pins the calling thread to one CPU, returns false if not supported or not permitted */
+bool core_pin_thread(uint32_t cpu);
+/* CPU the calling thread runs on, -1 if unknown */
+int32_t core_current_cpu(void);
+/* Hardware threads sharing a core with the CPU, including the CPU itself */
+std::vector<uint32_t> core_cpu_siblings(uint32_t cpu);
+/* CPUs listed in isolcpus and nohz_full */
+std::vector<uint32_t> core_isolated_cpus(void);
+/* Applies the policy to the calling thread, priority is the nice value for SCHED_POLICY_NICE */
+bool core_set_scheduler(core_sched_policy policy, int32_t priority);
+const char *core_sched_name(core_sched_policy policy);
+/* Locks all current and future pages of the process in memory */
+bool core_lock_memory(void);
+/* Writes every page of the block without changing its content, returns the number of pages */
+size_t core_prefault(void *block, size_t size);
+const char *core_numa_name(core_numa_policy policy);
+/* NUMA node of the CPU the calling thread runs on, -1 if unknown */
+int32_t core_current_node(void);
+/* NUMA nodes with memory, in ascending order */
+std::vector<uint32_t> core_memory_nodes(void);
+/* Allocates a block placed by the policy relative to the node of the calling thread,
+   anything but NUMA_POLICY_NONE maps whole pages so the policy applies to this block only */
+void *core_alloc_block(size_t size, core_numa_policy policy);
+void core_free_block(void *block, size_t size, core_numa_policy policy);
+/* Number of resident pages of the block on each node, indexed by node */
+std::vector<uint32_t> core_block_nodes(void *block, size_t size);
+
+/* OS resource counters of one thread */
+struct core_usage
+{
+    uint64_t voluntary;   /* Context switches while waiting */
+    uint64_t involuntary; /* Preemptions */
+    uint64_t migrations;  /* Moves to another CPU, from the scheduler statistics */
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    bool migrations_ok; /* /proc/thread-self/sched is available */
+};
+
+/* Counters of the calling thread, false if not supported */
+bool core_thread_usage(core_usage *u);
+/* Difference of two snapshots of the same thread */
+core_usage core_usage_delta(const core_usage &start, const core_usage &stop);
+/* Peak resident set size of the process in KiB, and of its reaped children for children */
+uint64_t core_peak_rss(bool children);
+
+/* CPU limits and CFS statistics of the cgroup v2 of the process */
+struct core_cgroup
+{
+    double quota;            /* CPUs granted by cpu.max of the cgroup and its ancestors, 0 without a limit */
+    uint32_t cpuset;         /* CPUs in cpuset.cpus.effective, 0 if unknown */
+    uint64_t nr_periods;     /* cpu.stat counters */
+    uint64_t nr_throttled;
+    uint64_t throttled_usec;
+};
+
+/* Returns false if the process is not in a cgroup v2 hierarchy */
+bool core_read_cgroup(core_cgroup *cg);
+/* Allowed CPUs, limited by the cgroup cpuset and by the cpu.max quota rounded up */
+uint32_t core_default_threads(void);
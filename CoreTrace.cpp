@@ -0,0 +1,223 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "CoreTrace.h"
+
+#include "CoreIsa.h"      // for core_isa
+#include "CoreListJoin.h" // for core_results, core_init_context, core_snapshot_take, core_snapshot_restore
+#include "CoreUtil.h"     // for crcu16
+
+#include <chrono>  // for steady_clock, duration
+#include <cstdio>  // for fopen, fread, fwrite, printf
+#include <cstdlib> // for free, malloc
+#include <cstring> // for memcmp, memcpy
+
+#define TRACE_MAGIC "CMTRACE1"
+#define TRACE_HEADER_BYTES 32
+
+/* Little endian file header of TRACE_HEADER_BYTES, followed by count calls of 3 bytes */
+struct trace_header
+{
+    char magic[8];
+    uint16_t seed1, seed2, seed3;
+    uint16_t check; /* crcu16 of the results of all calls in order */
+    uint32_t blksize;
+    uint32_t execs;
+    uint32_t iterations;
+    uint32_t count;
+};
+
+static void trace_put(uint8_t **p, uint32_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+        *(*p)++ = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t trace_get(const uint8_t **p, uint32_t bytes)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < bytes; i++)
+        value |= (uint32_t)*(*p)++ << (8 * i);
+    return value;
+}
+
+static void trace_encode_header(const trace_header *h, uint8_t *buf)
+{
+    uint8_t *p = buf + 8;
+    memcpy(buf, h->magic, 8);
+    trace_put(&p, h->seed1, 2);
+    trace_put(&p, h->seed2, 2);
+    trace_put(&p, h->seed3, 2);
+    trace_put(&p, h->check, 2);
+    trace_put(&p, h->blksize, 4);
+    trace_put(&p, h->execs, 4);
+    trace_put(&p, h->iterations, 4);
+    trace_put(&p, h->count, 4);
+}
+
+static void trace_decode_header(const uint8_t *buf, trace_header *h)
+{
+    const uint8_t *p = buf + 8;
+    memcpy(h->magic, buf, 8);
+    h->seed1 = (uint16_t)trace_get(&p, 2);
+    h->seed2 = (uint16_t)trace_get(&p, 2);
+    h->seed3 = (uint16_t)trace_get(&p, 2);
+    h->check = (uint16_t)trace_get(&p, 2);
+    h->blksize = trace_get(&p, 4);
+    h->execs = trace_get(&p, 4);
+    h->iterations = trace_get(&p, 4);
+    h->count = trace_get(&p, 4);
+}
+
+static uint16_t trace_call(core_results *res, const core_trace_call &call)
+{
+    int16_t dtype = call.op & 0xf;
+    res->crc = call.crc;
+    return core_isa()->workloads[call.op >> 4].bench(res, (int16_t)(dtype | (dtype << 4)));
+}
+
+bool core_trace_write(const char *path, core_results *res, uint32_t blksize)
+{
+    core_trace trace;
+    trace_header h;
+    uint8_t header[TRACE_HEADER_BYTES];
+    uint16_t check = 0;
+    bool ok;
+
+    res->trace = &trace;
+    core_isa()->iterate(res);
+    res->trace = nullptr;
+
+    for (const core_trace_call &call : trace)
+        check = crcu16(call.result, check);
+
+    memcpy(h.magic, TRACE_MAGIC, 8);
+    h.seed1 = (uint16_t)res->seed1;
+    h.seed2 = (uint16_t)res->seed2;
+    h.seed3 = (uint16_t)res->seed3;
+    h.check = check;
+    h.blksize = blksize;
+    h.execs = res->execs;
+    h.iterations = res->iterations;
+    h.count = (uint32_t)trace.size();
+    trace_encode_header(&h, header);
+
+    FILE *f = fopen(path, "wb");
+    if (f == nullptr)
+        return false;
+    ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    for (const core_trace_call &call : trace)
+    {
+        uint8_t buf[3], *p = buf;
+        trace_put(&p, call.op, 1);
+        trace_put(&p, call.crc, 2);
+        ok = ok && (fwrite(buf, 1, sizeof(buf), f) == sizeof(buf));
+    }
+    ok = (fclose(f) == 0) && ok;
+    printf("Trace            : %u calc_func dispatches in %u iterations written to %s, check 0x%04x\n", h.count, h.iterations, path, check);
+    return ok;
+}
+
+bool core_trace_replay(const char *path, uint32_t passes)
+{
+    core_results res{};
+    core_trace trace;
+    trace_header h;
+    uint8_t header[TRACE_HEADER_BYTES];
+    uint64_t calls[NUM_WORKLOADS] = {};
+    uint32_t i, pass;
+    bool ok = true;
+
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        printf("ERROR! Cannot open the trace %s\n", path);
+        return false;
+    }
+    if ((fread(header, 1, sizeof(header), f) != sizeof(header)) || (memcmp(header, TRACE_MAGIC, 8) != 0))
+    {
+        printf("ERROR! %s is not a trace\n", path);
+        fclose(f);
+        return false;
+    }
+    trace_decode_header(header, &h);
+    trace.resize(h.count);
+    for (i = 0; i < h.count; i++)
+    {
+        uint8_t buf[3];
+        const uint8_t *p = buf;
+        if ((fread(buf, 1, sizeof(buf), f) != sizeof(buf)) || ((buf[0] >> 4) >= NUM_WORKLOADS))
+        {
+            printf("ERROR! The trace %s is truncated or corrupt\n", path);
+            fclose(f);
+            return false;
+        }
+        trace[i].op = (uint8_t)trace_get(&p, 1);
+        trace[i].crc = (uint16_t)trace_get(&p, 2);
+        calls[trace[i].op >> 4]++;
+    }
+    fclose(f);
+
+    if ((h.execs == 0) || (h.execs & ~(workload_mask(NUM_WORKLOADS) - 1)) || (h.blksize == 0))
+    {
+        printf("ERROR! The trace %s has execs 0x%x and block size %u\n", path, h.execs, h.blksize);
+        return false;
+    }
+    res.seed1 = (int16_t)h.seed1;
+    res.seed2 = (int16_t)h.seed2;
+    res.seed3 = (int16_t)h.seed3;
+    res.execs = h.execs;
+    res.size = h.blksize / workload_shares(h.execs);
+    res.memblock[0] = malloc(h.blksize);
+    if (res.memblock[0] == nullptr)
+    {
+        printf("ERROR! Cannot allocate %u bytes for the replay\n", h.blksize);
+        return false;
+    }
+    core_init_context(&res);
+    /* the kernels change their data, every pass starts from the initialized block like the recorded run */
+    if (!core_snapshot_take(&res))
+    {
+        printf("ERROR! Cannot allocate the snapshot of the replay block\n");
+        free(res.memblock[0]);
+        return false;
+    }
+
+    double secs = 0;
+    for (pass = 0; pass < passes; pass++)
+    {
+        uint16_t check = 0;
+        core_snapshot_restore(&res);
+        auto start = std::chrono::steady_clock::now();
+        for (const core_trace_call &call : trace)
+            check = crcu16(trace_call(&res, call), check);
+        secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (check != h.check)
+        {
+            printf("[%u]ERROR! replay check 0x%04x - should be 0x%04x\n", pass, check, h.check);
+            ok = false;
+        }
+    }
+    core_snapshot_free(&res);
+    free(res.memblock[0]);
+
+    printf("Replay           : %u calls recorded in %u iterations, %u passes in %f secs\n", h.count, h.iterations, passes, secs);
+    for (i = 0; i < NUM_WORKLOADS; i++)
+        if (calls[i])
+            printf("Replay %-10s: %llu calls per pass\n", workloads[i].name, (unsigned long long)calls[i]);
+    if ((h.count > 0) && (passes > 0))
+        printf("Replay ns/call   : %f\n", secs * 1e9 / ((double)h.count * passes));
+    printf(ok ? "Replay validated.\n" : "Errors detected\n");
+    return ok;
+}
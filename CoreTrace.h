@@ -0,0 +1,41 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct core_results;
+
+/* One dispatch of calc_func to a workload, 3 bytes in the trace file */
+struct core_trace_call
+{
+    uint8_t op;      /* workload index in the high nibble, dtype nibble in the low nibble */
+    uint16_t crc;    /* res->crc the workload folded its result into */
+    uint16_t result; /* only kept in memory for the check value */
+};
+
+using core_trace = std::vector<core_trace_call>;
+
+inline void core_trace_record(core_trace *trace, uint32_t index, int16_t dtype, uint16_t crc, uint16_t result)
+{
+    trace->push_back({(uint8_t)((index << 4) | (dtype & 0xf)), crc, result});
+}
+
+/* Runs the iterations of the context with calc_func recording every dispatch, and writes the trace */
+bool core_trace_write(const char *path, core_results *res, uint32_t blksize);
+/* Runs the workload kernels of a trace passes times without the list traversal, and checks that every
+   call returns what it returned while recording */
+bool core_trace_replay(const char *path, uint32_t passes);
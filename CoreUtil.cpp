@@ -18,6 +18,8 @@ Original Author: Shay Gal-on
 
 #include "CoreUtil.h"
 
+CORE_KERNEL_BEGIN
+
 int32_t parseval(char *valstring)
 {
     int32_t retval = 0;
@@ -116,3 +118,5 @@ uint16_t crc16(int16_t newval, uint16_t crc)
 {
     return crcu16((uint16_t)newval, crc);
 }
+
+CORE_KERNEL_END
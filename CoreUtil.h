@@ -18,8 +18,11 @@ Original Author: Shay Gal-on
 
 #pragma once
 
+#include "CoreKernel.h"
 #include <cstdint>
 
+CORE_KERNEL_BEGIN
+
 int32_t parseval(char *valstring);
 
 int32_t get_seed_args(int i, int argc, char *argv[]);
@@ -28,3 +31,5 @@ uint16_t crcu8(uint8_t data, uint16_t crc);
 uint16_t crc16(int16_t newval, uint16_t crc);
 uint16_t crcu16(uint16_t newval, uint16_t crc);
 uint16_t crcu32(uint32_t newval, uint16_t crc);
+
+CORE_KERNEL_END
@@ -0,0 +1,131 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreKernel.h"
+#include <cstdint>
+#include <type_traits> // for integral_constant
+#include <utility>     // for integer_sequence
+
+struct core_results;
+
+/* Index of the workload in the registry, bit position in execs and slot in core_results crcs */
+enum core_workload_index
+{
+    WORKLOAD_LIST,
+    WORKLOAD_MATRIX,
+    WORKLOAD_STATE,
+    WORKLOAD_CHASE,
+    NUM_WORKLOADS,
+};
+
+/* Number of seed and size combinations with known CRC values */
+#define NUM_KNOWN_IDS 5
+
+enum core_dispatch
+{
+    DISPATCH_ITERATE, /* bench is called once per iteration by iterate */
+    DISPATCH_CALC,    /* bench is called by calc_func when the list data selects calc_flag, or once per iteration without the list */
+};
+
+struct core_workload
+{
+    const char *name;
+    core_dispatch dispatch;
+    int16_t calc_flag; /* Value of the calc_func flag bits dispatching to this workload */
+    bool standard;     /* Part of the default execs mask */
+    uint32_t share;    /* Relative share of the memory block */
+    void (*init)(core_results *res, uint32_t blksize, void *memblk);
+    /* DISPATCH_ITERATE folds its work into res->crc and returns the value kept in its CRC slot,
+       DISPATCH_CALC returns the value calc_func folds into res->crc */
+    uint16_t (*bench)(core_results *res, int16_t arg);
+    uint16_t known_crc[NUM_KNOWN_IDS];      /* CRC of the first iteration for each known seed set */
+    uint16_t standalone_crc[NUM_KNOWN_IDS]; /* DISPATCH_CALC run by iterate when the list is disabled */
+};
+
+CORE_KERNEL_BEGIN
+
+void workload_list_init(core_results *res, uint32_t blksize, void *memblk);
+uint16_t workload_list_bench(core_results *res, int16_t arg);
+void workload_matrix_init(core_results *res, uint32_t blksize, void *memblk);
+uint16_t workload_matrix_bench(core_results *res, int16_t arg);
+void workload_state_init(core_results *res, uint32_t blksize, void *memblk);
+uint16_t workload_state_bench(core_results *res, int16_t arg);
+void workload_chase_init(core_results *res, uint32_t blksize, void *memblk);
+uint16_t workload_chase_bench(core_results *res, int16_t arg);
+
+inline constexpr core_workload workloads[NUM_WORKLOADS] = {
+    {"list", DISPATCH_ITERATE, -1, true, 1, workload_list_init, workload_list_bench, {0xd4b0, 0x3340, 0x6a79, 0xe714, 0xe3c1}, {}},
+    {"matrix", DISPATCH_CALC, 1, true, 1, workload_matrix_init, workload_matrix_bench, {0xbe52, 0x1199, 0x5608, 0x1fd7, 0x0747},
+     {0xa768, 0x3ed3, 0x22cf, 0x2445, 0x7176}},
+    {"state", DISPATCH_CALC, 0, true, 1, workload_state_init, workload_state_bench, {0x5e47, 0x39bf, 0xe5a4, 0x8e3a, 0x8d84},
+     {0x5e47, 0xb45a, 0x5abd, 0xe10b, 0x1433}},
+    {"chase", DISPATCH_ITERATE, -1, false, 1, workload_chase_init, workload_chase_bench, {0x7d11, 0x1fe9, 0xb3b3, 0x825f, 0x71b3}, {}},
+};
+
+constexpr uint32_t workload_mask(uint32_t index)
+{
+    return 1u << index;
+}
+
+constexpr uint32_t standard_workloads_mask(void)
+{
+    uint32_t i, mask = 0;
+    for (i = 0; i < NUM_WORKLOADS; i++)
+        if (workloads[i].standard)
+            mask |= workload_mask(i);
+    return mask;
+}
+
+constexpr uint32_t workload_shares(uint32_t execs)
+{
+    uint32_t i, shares = 0;
+    for (i = 0; i < NUM_WORKLOADS; i++)
+        if (execs & workload_mask(i))
+            shares += workloads[i].share;
+    return shares;
+}
+
+/* Calls f with std::integral_constant<uint32_t, index> for every workload, so the hot paths
+   can select workloads with if constexpr and call their bench functions directly */
+template <typename F, uint32_t... I> constexpr void for_each_workload(F &&f, std::integer_sequence<uint32_t, I...>)
+{
+    (f(std::integral_constant<uint32_t, I>{}), ...);
+}
+
+template <typename F> constexpr void for_each_workload(F &&f)
+{
+    for_each_workload(f, std::make_integer_sequence<uint32_t, NUM_WORKLOADS>{});
+}
+
+/* Known CRC of the workload when it runs in a context with these execs, nullptr if the tables do not cover them.
+   The list and the DISPATCH_CALC workloads feed each other's CRCs, so the known CRCs hold for all of them together,
+   and the standalone CRCs for one DISPATCH_CALC workload without the list. */
+constexpr const uint16_t *workload_known_crcs(uint32_t index, uint32_t execs)
+{
+    uint32_t i, coupled = workload_mask(WORKLOAD_LIST);
+    for (i = 0; i < NUM_WORKLOADS; i++)
+        if (workloads[i].dispatch == DISPATCH_CALC)
+            coupled |= workload_mask(i);
+    if (!(coupled & workload_mask(index)))
+        return workloads[index].known_crc;
+    if ((execs & coupled) == (standard_workloads_mask() & coupled))
+        return workloads[index].known_crc;
+    if ((workloads[index].dispatch == DISPATCH_CALC) && ((execs & coupled) == workload_mask(index)))
+        return workloads[index].standalone_crc;
+    return nullptr;
+}
+
+CORE_KERNEL_END